@@ -0,0 +1,29 @@
+#pragma once
+
+#include "grid.hpp"
+#include "point.hpp"
+#include "intcode.hpp"
+
+
+class HullBrush {
+
+    public:
+
+    HullBrush() : current_position({0, 0}), current_direction({0,1}) {}
+    void step();
+    void print();
+    void paint(const bool);
+    void turn(const bool);
+    bool is_current_position_white() const;
+    size_t count_painted_positions() const;
+
+    private:
+
+    // '#' white and '.' black, blank if never painted
+    Grid<char> panels{' '};
+    Point current_position;
+    Point current_direction;
+};
+
+// runs the robot until it halts, feeding it the panel under the brush and following its orders
+void paint_hull(IntcodeComputer &, HullBrush &);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+
+#include "grid.hpp"
+#include "point.hpp"
+#include "intcode.hpp"
+
+
+using Field = Grid<char>;
+
+
+class Arkanoid {
+    public:
+
+    Arkanoid(Text &text) : computer(0, text), field(' ') {}
+    // plays until the game is over, moving the pad under the ball; on screen, the field is
+    // drawn after every move and slowed down enough to be watched
+    void auto_play(bool on_screen = true);
+    Value get_score() const { return current_score; }
+    uint64_t instructions_executed() const { return computer.instructions_executed(); }
+
+    private:
+
+    void process_computer_output(Value);
+    void refresh_screen();
+
+    IntcodeComputer computer;
+    Field field;
+    size_t q_blocks{};
+    Point ball_position;
+    Point pad_position;
+    Value current_score{};
+    // x, y and object of the draw command being received
+    array<Value, 3> command;
+    size_t q_command{};
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include "grid.hpp"
+#include "point.hpp"
+#include "intcode.hpp"
+
+
+// what the droid finds: walls and open positions, unexplored ones being blank, and the tank
+struct Section {
+    Grid<char> map{' '};
+    Point tank_position;
+};
+
+Value get_direction_code(const Point &);
+Value try_direction(IntcodeComputer &, const Point &);
+// explores everything reachable from position, forking the computer at every open position;
+// returns the instructions the forks executed
+uint64_t map_section(const IntcodeComputer &, const Point &, Section &);
+// steps from the origin to the tank, and minutes for oxygen to spread from it everywhere
+pair<size_t, size_t> compute_movements_and_minutes(const Section &);
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+
+#include "intcode.hpp"
+
+
+// ids of the systems the diagnostic program can test
+constexpr Value AIR_CONDITIONER_ID = 1;
+constexpr Value THERMAL_RADIATOR_ID = 5;
+
+// runs the diagnostic program for the system with that id, returning what it outputs: the
+// test results and then the diagnostic code
+vector<Value> run_diagnostic(IntcodeComputer &, Value);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "intcode.hpp"
+
+
+// the amplifiers can be searched from several threads at once, so the instructions they execute
+// are added up in an atomic counter, when one is given
+
+// feeds a signal to the amplifier, returning the one it answers with
+Value amplify(IntcodeComputer &, Value);
+
+// one pass through the amplifiers in series, each a fresh program set to its phase
+Value get_series_thruster_signal(const Text &, const vector<Value> &phases, atomic<uint64_t> * = nullptr);
+// the highest series signal over every ordering of the phases
+Value get_max_series_thruster_signal(const Text &, const vector<Value> &phases, atomic<uint64_t> * = nullptr);
+
+// the amplifiers in a feedback loop, round-robin until the last one halts
+Value get_feedback_thruster_signal(const Text &, vector<Value> &phases, atomic<uint64_t> * = nullptr);
+// the same loop with a thread per amplifier
+Value get_feedback_thruster_signal_pipelined(const Text &, vector<Value> &phases, atomic<uint64_t> * = nullptr);
+
+using SignalFunction = Value (*)(const Text &, vector<Value> &, atomic<uint64_t> *);
+// the highest feedback signal over every ordering of the phases
+Value get_max_feedback_thruster_signal(const Text &, vector<Value> &phases, SignalFunction, atomic<uint64_t> * = nullptr);
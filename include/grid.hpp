@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "point.hpp"
+
+using namespace std;
+
+
+// dense 2D grid of cells addressed by Point, stored row by row. it starts out empty and grows
+// to take in every point written to, a chunk at a time on whichever side runs short so walking
+// off an edge doesn't reallocate at every step; reading outside of it gives the background
+template <typename T>
+class Grid {
+
+    static_assert(!is_same<T, bool>::value, "vector<bool> has no addressable cells, use char");
+
+    public:
+
+    explicit Grid(const T &background = T{}) : background(background) {}
+
+    const T &at(const Point &p) const {
+        return is_allocated(p) ? cells[index(p)] : background;
+    }
+
+    T &operator[](const Point &p) {
+        if (!is_allocated(p))
+            grow(p);
+
+        if (!written) {
+            min = max = p;
+            written = true;
+        }
+        else {
+            min = Point{std::min(min.x, p.x), std::min(min.y, p.y)};
+            max = Point{std::max(max.x, p.x), std::max(max.y, p.y)};
+        }
+        return cells[index(p)];
+    }
+
+    // bounds of the points written to, both inclusive
+    bool empty() const { return !written; }
+    const Point &get_min() const { return min; }
+    const Point &get_max() const { return max; }
+
+    // the cells of row y from get_min().x to get_max().x, y being within the bounds
+    const T *row(int y) const {
+        return &cells[index(Point{min.x, y})];
+    }
+
+    // every cell within the bounds, row by row
+    template <typename Visit>
+    void for_each(Visit visit) const {
+        if (!written)
+            return;
+        for (int y{min.y}; y<=max.y; ++y) {
+            const T *cell = row(y);
+            for (int x{min.x}; x<=max.x; ++x)
+                visit(Point{x, y}, *cell++);
+        }
+    }
+
+    template <typename Predicate>
+    size_t count_if(Predicate predicate) const {
+        size_t q_cells{};
+        for_each([&](const Point &, const T &cell) {
+            if (predicate(cell))
+                ++q_cells;
+        });
+        return q_cells;
+    }
+
+    private:
+
+    static constexpr int CHUNK{32};
+
+    bool is_allocated(const Point &p) const {
+        return p.x >= origin.x && p.x < origin.x + width && p.y >= origin.y && p.y < origin.y + height;
+    }
+
+    size_t index(const Point &p) const {
+        return static_cast<size_t>(p.y - origin.y) * width + (p.x - origin.x);
+    }
+
+    void grow(const Point &p) {
+        if (cells.empty()) {
+            origin = Point{p.x - CHUNK / 2, p.y - CHUNK / 2};
+            width = height = CHUNK;
+            cells.assign(static_cast<size_t>(width) * height, background);
+            return;
+        }
+
+        // a chunk past the point, or as much again as there is already, whichever is more
+        auto extra = [](int short_by, int size) { return short_by ? std::max(short_by + CHUNK, size) : 0; };
+        int left = extra(std::max(0, origin.x - p.x), width);
+        int right = extra(std::max(0, p.x - (origin.x + width - 1)), width);
+        int before = extra(std::max(0, origin.y - p.y), height);
+        int after = extra(std::max(0, p.y - (origin.y + height - 1)), height);
+
+        int new_width = width + left + right;
+        int new_height = height + before + after;
+        vector<T> grown(static_cast<size_t>(new_width) * new_height, background);
+        for (int y{}; y<height; ++y) {
+            auto old_row = cells.begin() + static_cast<size_t>(y) * width;
+            move(old_row, old_row + width, grown.begin() + static_cast<size_t>(y + before) * new_width + left);
+        }
+
+        cells = move(grown);
+        origin = Point{origin.x - left, origin.y - before};
+        width = new_width;
+        height = new_height;
+    }
+
+    T background;
+    vector<T> cells;
+    // of the allocated cells
+    Point origin;
+    int width{};
+    int height{};
+    Point min;
+    Point max;
+    bool written{false};
+};
@@ -1,6 +1,16 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <functional>
 #include <vector>
 #include <map>
+#include <memory>
+#include <ostream>
 #include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 using namespace std;
 
@@ -9,7 +19,121 @@ using Value = int64_t;
 using Address = int64_t;
 using Text = vector<Value>;
 using Heap = map<Value, Value>;
+// receives each output as it is produced, instead of queueing it
+using OutputSink = function<void(Value)>;
+
+constexpr int PAGE_BITS = 10;
+constexpr Address PAGE_SIZE = Address{1} << PAGE_BITS;
+// addresses past the page table go to a sparse map instead
+constexpr size_t MAX_PAGES = 16384;
+
+
+// compiled program files: "ICBN" magic, version, value width in bytes, flags, amount of
+// words, then the words as little-endian int64. loading one is a single mmap and copy
+struct BinaryProgramHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t value_width;
+    // reserved for optional sections, none defined yet
+    uint32_t flags;
+    uint64_t q_words;
+};
+
+// VM snapshots: "ICSS" magic, version, value width, flags, registers and section sizes, then
+// the indices of the pages present, far heap address and value pairs, pending inputs and
+// outputs, and from the next 4 KiB boundary the pages themselves, all as little-endian int64.
+// restoring maps the file and points the pages straight into it
+struct IntcodeSnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t value_width;
+    // bit 0: terminated
+    uint32_t flags;
+    int64_t ip;
+    int64_t relative_base;
+    uint64_t text_size;
+    uint64_t q_executed;
+    uint64_t q_pages;
+    uint64_t q_far_words;
+    uint64_t q_inputs;
+    uint64_t q_outputs;
+};
+
+Text read_text_program(const char *);
+Text read_binary_program(const char *);
+void write_binary_program(const Text &, const char *);
+bool is_binary_program(const char *);
+
+
+// an instruction translated out of memory: opcode, parameter modes and raw parameter words
+struct Instruction {
+    int opcode;
+    // dense index into the interpreter dispatch table, 0 for invalid opcodes
+    int handler;
+    array<int, 3> modes;
+    array<Value, 3> params;
+    int q_params;
+    // words covered past the opcode, more than q_params once a jump is fused on
+    int span;
+    // the fused jump tests the value this instruction writes, without reading it back
+    bool forward_result;
+    bool decoded;
+
+    static Instruction decode(Value);
+};
+
+// longest span of words a cached instruction can cover, a compare plus a fused jump
+constexpr Address MAX_INSTRUCTION_SPAN = 6;
+
+
+// x86-64 Linux builds can run programs as native code, see intcode_jit.hpp; -DINTCODE_NO_JIT
+// leaves it out, and so does profiling, which counts every instruction one by one.
+// -DINTCODE_JIT_ALWAYS enables it on every computer, to run whole test suites or days through it
+#if defined(__x86_64__) && defined(__linux__) && !defined(INTCODE_NO_JIT) && !defined(INTCODE_PROFILE)
+#define INTCODE_JIT
+#endif
+
+#ifdef INTCODE_JIT
+struct JitCode;
+#endif
+
 
+#ifdef INTCODE_PROFILE
+// execution counters, only compiled in when building with -DINTCODE_PROFILE
+struct IntcodeProfile {
+    uint64_t q_instructions{};
+    // by Instruction::handler
+    array<uint64_t, 14> q_by_handler{};
+    // by opcode plus parameter modes, as in the instruction word
+    unordered_map<int, uint64_t> q_by_word;
+    unordered_map<Address, uint64_t> q_by_address;
+    uint64_t q_input_stalls{};
+
+    uint64_t q_text_reads{};
+    uint64_t q_text_writes{};
+    uint64_t q_heap_reads{};
+    uint64_t q_heap_writes{};
+
+    void count(const Instruction &, Address);
+    void stall(const Instruction &, Address);
+    void write_json(ostream &) const;
+    void write_folded(ostream &, int, Address) const;
+};
+#endif
+
+
+// memory words live in lazily allocated pages, a missing page reads as zeroes.
+// pages are shared between forked computers and copied on their first write
+using Page = array<Value, PAGE_SIZE>;
+using PageTable = vector<shared_ptr<Page>>;
+
+// decode cache for the instructions starting in a page, shared and copied the same way
+struct DecodedPage {
+    array<Instruction, PAGE_SIZE> instructions;
+    // words read by some cached instruction, so that plain data writes skip the invalidation
+    bitset<PAGE_SIZE> covered;
+};
+using DecodedPageTable = vector<shared_ptr<DecodedPage>>;
 
 
 class Memory {
@@ -19,40 +143,121 @@ class Memory {
     Memory(Text& text);
     Value get(Value);
     void set(Address, Value);
+    const Instruction &fetch(Address);
     void print();
 
+#ifdef INTCODE_PROFILE
+    // lives here so memory accesses can count themselves, and is copied along with forks
+    IntcodeProfile profile;
+#endif
+
     private:
 
-    Text text;
-    Heap heap;
+    // snapshots read and rebuild the pages directly
+    friend class IntcodeComputer;
+    friend struct JitRunner;
+
+    Page &writable_page(size_t);
+    DecodedPage &writable_decoded_page(size_t);
+    void invalidate_decoded(size_t, Address);
+    const Instruction *cached(Address) const;
+    const Instruction &translate(Address);
+    void fuse(Address);
+
+    size_t text_size;
+    PageTable pages;
+    Heap far_heap;
+
+    // only instructions lying entirely in one page are cached, so a write
+    // can find every entry it touches within the few slots before it
+    DecodedPageTable decoded;
+    Instruction decoded_uncached;
+
+#ifdef INTCODE_JIT
+    JitCode &writable_jit();
+    void invalidate_compiled(Address);
+    // the native code of the block starting there, compiling it if it can be
+    const uint8_t *compiled(Address);
+    // every word the decode cache covers, so that compiled code leaves it to set()
+    void watch_decoded(Address, Address);
+
+    // nullptr unless the JIT is enabled
+    shared_ptr<JitCode> jit;
+    // set when a write drops a compiled block
+    bool jit_invalidated{false};
+#endif
 };
 
 
+// why run() with an instruction budget returned
+enum class RunStatus { halted, needs_input, budget_exhausted, output_available };
+
 class IntcodeComputer {
 
     public:
 
     IntcodeComputer(int, Text);
+    IntcodeComputer fork() const;
+    // already past everything the program does before its first input read
+    static IntcodeComputer partially_evaluated(int, Text);
     void push_input(Value);
     Value run();
+    // inputs come from the span once the queue is empty and outputs go to the sink, so neither
+    // goes through a queue; returns how many values of the span were taken
+    size_t run(const Value *, size_t, const OutputSink &);
+    // a time slice: at most that many instructions (a fused pair may go one over), also
+    // stopping right after each output so it can be passed on; resumes where it left off
+    RunStatus run(uint64_t);
     Value pop_output();
     size_t output_size();
+    // ASCII programs: a line of input, newline included, and the queued output as text up to
+    // the first value that isn't a character, left queued; returns how many were appended
+    void push_line(string_view);
+    size_t drain_text(string &);
     bool has_terminated();
+    // since it was constructed, a fused pair counting as two
+    uint64_t instructions_executed() const;
+    // runs from here on as native code where it can, leaving the rest to the interpreter;
+    // false where there is no JIT, see INTCODE_JIT
+    bool enable_jit();
+    // how many of the instructions executed ran as native code
+    uint64_t native_instructions_executed() const;
     static IntcodeComputer from_file(const int id, const char *);
+    // the whole state, to carry on later from where it stands now
+    void save(const char *) const;
+    static IntcodeComputer restore(const int id, const char *);
 
-    private:
+#ifdef INTCODE_PROFILE
+    const IntcodeProfile &get_profile();
+    void write_profile_json(ostream &);
+    // flamegraph folded stacks: computer, block of addresses, instruction
+    void write_profile_folded(ostream &, Address block_size = 64);
+#endif
 
-    inline int parse_opcode(int);
-    int parse_parameter_mode(int, int);
+    private:
 
-    Value get_read_param(int);
-    Address get_write_address(int);
+    Value get_read_param(const Instruction &, int);
+    Address get_write_address(const Instruction &, int);
+    void fused_jump(const Instruction &, Value);
+    RunStatus execute(uint64_t, bool);
+    RunStatus interpret(uint64_t, bool);
     void log(const char *);
 
     int id;
     queue<Value> input;
     queue<Value> output;
+    // only set during run() with a span and a sink
+    const Value *input_span{};
+    const Value *input_span_end{};
+    const OutputSink *output_sink{};
     bool terminated;
+    uint64_t q_executed{};
+
+#ifdef INTCODE_JIT
+    friend struct JitRunner;
+    RunStatus execute_compiled(uint64_t, bool);
+    uint64_t q_native{};
+#endif
 
     Memory memory;
     Address ip;
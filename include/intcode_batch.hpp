@@ -0,0 +1,49 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// runs many instances (lanes) of the same program in lockstep.
+// lanes sharing an ip and instruction word execute it together, so the per-lane work is a
+// tight loop over contiguous memory; lanes that branch away wait until the rest catch up
+class IntcodeBatch {
+
+    public:
+
+    IntcodeBatch(const Text &, size_t);
+    void set(size_t, Address, Value);
+    Value get(size_t, Address) const;
+    void push_input(size_t, Value);
+    void run();
+    Value pop_output(size_t);
+    size_t output_size(size_t) const;
+    bool has_terminated(size_t) const;
+    size_t size() const;
+
+    private:
+
+    enum class LaneState { running, waiting_input, terminated };
+
+    inline Value &word(Address, size_t);
+    inline void write(size_t, Address, Value);
+    void grow(Address);
+    Value get_read_param(const Instruction &, size_t, int);
+    Address get_write_address(const Instruction &, size_t, int);
+    void step(const vector<size_t> &);
+
+    // structure of arrays, the word at address a for lane l is words[a * q_lanes + l]
+    vector<Value> words;
+    size_t q_lanes;
+    Address q_addresses;
+
+    vector<Address> ip;
+    vector<Address> relative_base;
+    vector<LaneState> state;
+    vector<queue<Value>> input;
+    vector<queue<Value>> output;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// remembers the outputs of whole runs, keyed by program and inputs.
+// Intcode has no state besides memory and its input queue, so a program that halts on the
+// inputs given always produces the same outputs; runs that want more input are not cached.
+// holds up to a capacity of runs, evicting the least recently used one
+class IntcodeRunCache {
+
+    public:
+
+    explicit IntcodeRunCache(size_t);
+    // the id runs of the program are keyed by: its hash, or the next free one after it when a
+    // different program already has that
+    uint64_t add(const Text &);
+    // a copy of the outputs, the entry they come from may be evicted by the next run
+    vector<Value> run(uint64_t, const vector<Value> &);
+    size_t size() const;
+    size_t hits() const;
+    size_t misses() const;
+
+    private:
+
+    struct Key {
+        uint64_t program;
+        vector<Value> inputs;
+        bool operator==(const Key &) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &) const;
+    };
+
+    struct Entry {
+        Key key;
+        vector<Value> outputs;
+    };
+
+    struct Program {
+        // compared on every add, ids come from a hash that may collide
+        Text text;
+        // already run up to its first input read
+        IntcodeComputer start;
+    };
+
+    size_t capacity;
+    size_t q_hits{};
+    size_t q_misses{};
+    unordered_map<uint64_t, Program> programs;
+    // most recently used first
+    list<Entry> entries;
+    unordered_map<Key, list<Entry>::iterator, KeyHash> index;
+};
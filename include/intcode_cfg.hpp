@@ -0,0 +1,95 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// static view of an Intcode program: the instructions reachable from address 0, split into
+// basic blocks, with what can be told about self-modification and subroutine calls without
+// running it. jumps through memory are only followed when their target is a return address
+// pushed as a constant, so code reached only through computed jumps is left out.
+// it is for tools, the disassembler and the ahead of time compiler: the interpreter and the JIT
+// decode what is in memory when they get there, which a self-modifying program may have changed
+// from what its text holds
+
+// an instruction as it stands in the text, parameter words included
+struct ProgramInstruction {
+    Address address;
+    Instruction instruction;
+    // a known opcode with valid modes and all its words within the text
+    bool valid;
+
+    Address next() const;
+    bool is_jump() const;
+    // a jump whose condition is an immediate that always or never holds
+    bool always_jumps() const;
+    bool never_jumps() const;
+    // where it jumps to when that is an immediate
+    bool has_constant_target() const;
+    // writes a result, the last parameter being where to
+    bool writes() const;
+};
+
+struct BasicBlock {
+    Address begin;
+    // past the last word of its last instruction
+    Address end;
+    vector<Address> instructions;
+    // blocks it continues into, jump targets resolved where immediate
+    vector<Address> successors;
+    // ends in a jump whose target is only known at run time
+    bool computed_exit;
+    bool halts;
+};
+
+// an instruction writing through a constant address into a word of a reachable instruction
+struct SelfModifyingWrite {
+    Address writer;
+    Address word;
+    Address instruction;
+};
+
+// relative base calling convention: a return address stored as a constant, then a jump to
+// the subroutine, which comes back through a jump to a relative base slot
+struct Call {
+    Address site;
+    Address target;
+    Address return_address;
+};
+
+class ControlFlowGraph {
+
+    public:
+
+    explicit ControlFlowGraph(const Text &);
+    const Text &get_text() const;
+    const map<Address, ProgramInstruction> &get_instructions() const;
+    const map<Address, BasicBlock> &get_blocks() const;
+    const vector<SelfModifyingWrite> &get_self_modifying_writes() const;
+    const vector<Call> &get_calls() const;
+    // jumps through a relative base slot, the way subroutines return
+    const vector<Address> &get_returns() const;
+    // nullptr unless an instruction reachable from address 0 starts there, decoded as it
+    // stands in the text
+    const ProgramInstruction *instruction_at(Address) const;
+    // a listing by basic block with calls, returns and self-modifying writes annotated
+    void write(ostream &) const;
+
+    private:
+
+    void find_instructions();
+    void find_blocks();
+    void find_self_modifying_writes();
+
+    Text text;
+    map<Address, ProgramInstruction> instructions;
+    map<Address, BasicBlock> blocks;
+    vector<SelfModifyingWrite> self_modifying_writes;
+    vector<Call> calls;
+    vector<Address> returns;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// Intcode programs translated ahead of time to C++ by intcode_aot.
+// the generated code runs on a flat memory array with one label per reachable instruction;
+// anything it can't follow statically, a jump to an address it didn't translate or a write
+// into its own instructions, escapes to an interpreter in CompiledIntcodeComputer
+
+struct CompiledState;
+
+enum class CompiledExit { halted, needs_input, escape };
+
+// what a generated translation unit exports
+struct CompiledProgram {
+    const Value *text;
+    size_t text_size;
+    // words belonging to translated instructions, writing to one ends the compiled run for good
+    const bool *code;
+    // flat memory the generated code addresses directly, covering every constant address
+    size_t memory_size;
+    CompiledExit (*run)(CompiledState &);
+};
+
+// shared between the generated code and the computer running it
+struct CompiledState {
+    const CompiledProgram *program;
+    vector<Value> memory;
+    Heap far_heap;
+    Address ip{};
+    Address relative_base{};
+    queue<Value> input;
+    queue<Value> output;
+    bool terminated{false};
+    bool code_modified{false};
+
+    Value read(Address);
+    void write(Address, Value);
+};
+
+// the IntcodeComputer interface over a compiled program
+class CompiledIntcodeComputer {
+
+    public:
+
+    CompiledIntcodeComputer(int, const CompiledProgram &);
+    void push_input(Value);
+    Value run();
+    Value pop_output();
+    size_t output_size();
+    bool has_terminated();
+
+    private:
+
+    bool step();
+    Value get_read_param(const Instruction &, int);
+    Address get_write_address(const Instruction &, int);
+
+    int id;
+    CompiledState state;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// native x86-64 code for IntcodeComputer, see IntcodeComputer::enable_jit. when execution
+// reaches an address with no code yet, the block starting there is compiled together with
+// every block reachable from it through constant jumps, into one mmap'd executable region.
+// a block is straight line code up to a jump or a halt; jumps look their target up in a table
+// of entry points and carry on there without going back to the dispatch loop.
+//
+// compiled code keeps the relative base and the instruction count in registers, and reads and
+// writes the computer's pages directly. it goes through Memory for the far heap, for pages it
+// shares with a fork and for watched words: those of compiled instructions and of
+// instructions the interpreter has decoded. a write to a compiled instruction drops its block
+// and marks the word volatile, so anything covering it runs in the interpreter from then on
+
+// compiled code covers addresses below this, past it everything is interpreted
+constexpr Address JIT_MAX_ADDRESS = Address{1} << 20;
+// longest block, so a time slice knows whether the next one fits
+constexpr uint64_t JIT_MAX_BLOCK_INSTRUCTIONS = 32;
+
+// what a word is watched for
+constexpr uint8_t WATCH_COMPILED = 1;
+constexpr uint8_t WATCH_DECODED = 2;
+constexpr uint8_t WATCH_VOLATILE = 4;
+
+
+// executable memory holding the blocks compiled together, unmapped along with the last
+// JitCode referring to it
+class JitRegion {
+
+    public:
+
+    explicit JitRegion(const vector<uint8_t> &);
+    ~JitRegion();
+    JitRegion(const JitRegion &) = delete;
+    JitRegion &operator=(const JitRegion &) = delete;
+    const uint8_t *get_code() const;
+
+    private:
+
+    uint8_t *code;
+    size_t size;
+};
+
+struct CompiledBlock {
+    Address begin;
+    // past its last word
+    Address end;
+    const uint8_t *body;
+    bool live;
+};
+
+// the code compiled out of one Memory, shared between forks and copied on the first change,
+// the same as its pages
+struct JitCode {
+    // by address, the block starting there
+    vector<const uint8_t *> entries;
+    // by address, WATCH_ bits; nothing past the end is watched
+    vector<uint8_t> watch;
+    vector<CompiledBlock> blocks;
+    vector<shared_ptr<JitRegion>> regions;
+};
+
+
+struct JitRunner;
+
+// what compiled code sees of the computer. registers are loaded on entry and stored back on
+// exit, the views are refreshed whenever the pages or the code change
+struct JitFrame {
+    Address ip;
+    Value relative_base;
+    uint64_t q_executed;
+    // blocks only chain into the next one while the instruction count stays at or below it
+    uint64_t chain_limit;
+
+    Value *const *readable;
+    // only pages this computer owns alone, nullptr for the rest
+    Value *const *writable;
+    uint64_t q_pages;
+    const uint8_t *watch;
+    uint64_t watch_size;
+    const uint8_t *const *entries;
+    uint64_t q_entries;
+
+    // the value the input helper took
+    Value input;
+    JitRunner *runner;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// cooperative scheduler for many communicating computers on a pool of worker threads.
+// a computer runs until it halts or blocks on empty input, which is its suspension point, or
+// for a time slice at most, after which it goes to the back of the ready queue so long
+// computations don't starve the rest; delivering input to a blocked computer puts it back too.
+// outputs go to the connected computer, if any, and are otherwise kept for the caller
+class IntcodeNetwork {
+
+    public:
+
+    size_t add(IntcodeComputer);
+    void connect(size_t, size_t);
+    void send(size_t, Value);
+    void run(size_t);
+    IntcodeComputer &computer(size_t);
+    const vector<Value> &outputs(size_t) const;
+    Value last_output(size_t) const;
+    size_t size() const;
+
+    private:
+
+    enum class NodeState { idle, queued, running };
+
+    struct Node {
+        Node(IntcodeComputer computer) : computer(computer) {}
+
+        IntcodeComputer computer;
+        bool connected{false};
+        size_t next{};
+        NodeState state{NodeState::idle};
+        bool started{false};
+
+        // written by other workers, guarded by the mutex
+        mutex lock;
+        vector<Value> mailbox;
+
+        // only touched by the worker running the node
+        vector<Value> outputs;
+        Value last_output{};
+    };
+
+    void deliver(size_t, Value);
+    void schedule(size_t);
+    void work();
+    void run_node(size_t);
+
+    vector<unique_ptr<Node>> nodes;
+
+    mutex scheduler_lock;
+    condition_variable scheduler_signal;
+    deque<size_t> ready;
+    // queued or running nodes, the network is done when it drops to zero
+    size_t q_busy{};
+};
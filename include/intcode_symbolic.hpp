@@ -0,0 +1,67 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "intcode.hpp"
+
+using namespace std;
+
+
+// runs a program with some of its cells patched to unknowns, leaving every cell as an
+// expression of them, so patch-and-search problems are solved instead of run for each guess.
+// only programs whose control flow doesn't depend on the unknowns can be run this way,
+// anything else throws
+class SymbolicRun {
+
+    public:
+
+    SymbolicRun(const Text &, const vector<Address> &);
+    // no products of unknowns in the final value of the cell
+    bool is_linear(Address) const;
+    Value evaluate(Address, const vector<Value> &) const;
+    // first values of the unknowns, each within its inclusive range, that leave the target in
+    // the cell; empty if there are none
+    vector<Value> solve(Address, Value, const vector<pair<Value, Value>> &) const;
+
+    private:
+
+    // opaque stands for a value that can't be expressed, such as a read from an unknown
+    // address; fine as long as nothing ends up depending on it
+    enum class Kind { constant, unknown, sum, product, opaque };
+
+    // nodes only refer to earlier ones, so the list is in topological order
+    struct Node {
+        Kind kind;
+        Value value;
+        size_t lhs;
+        size_t rhs;
+    };
+
+    // a constant or an index into nodes
+    struct Cell {
+        bool symbolic;
+        Value value;
+    };
+
+    struct LinearForm {
+        bool linear;
+        Value constant;
+        vector<Value> coefficients;
+    };
+
+    Cell make_node(Kind, Value, size_t = 0, size_t = 0);
+    Cell read(Address) const;
+    void write(Address, Cell);
+    Value concrete(Cell, const char *) const;
+    Cell add(Cell, Cell);
+    Cell multiply(Cell, Cell);
+    Cell get_read_param(const Instruction &, Address, int);
+    Address get_write_address(const Instruction &, Address, int) const;
+    LinearForm linear_form(Cell) const;
+
+    vector<Node> nodes;
+    vector<Cell> cells;
+    size_t q_unknowns;
+    Value relative_base{};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+string read_file(const char *);
+vector<int> parse_digits(const char *);
+
+
+// comma (or whitespace) separated integers, the whole file read at once and parsed in place
+template <typename T>
+vector<T> parse_csv_ints(const char *filename) {
+    const string contents = read_file(filename);
+
+    vector<T> integers;
+    integers.reserve(count(contents.begin(), contents.end(), ',') + 1);
+
+    const char *p = contents.data();
+    const char *end = p + contents.size();
+    while (p < end) {
+        if (*p == ',' || isspace(static_cast<unsigned char>(*p))) {
+            ++p;
+            continue;
+        }
+
+        T value;
+        auto [next, error] = from_chars(p, end, value);
+        if (error != errc())
+            throw runtime_error(string("Invalid integer in ") + string(filename));
+
+        integers.push_back(value);
+        p = next;
+    }
+
+    return integers;
+}
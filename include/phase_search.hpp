@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+// searches for the best ordering of a set of phases on a pool of threads. the search is split
+// into the orderings of the first few phases, enough of them to keep every thread busy, which
+// the threads then take one at a time and finish off
+
+using Phase = int64_t;
+
+// how many leading phases to split the search on: fewest giving a few tasks per thread
+inline size_t get_split_depth(size_t q_phases, size_t q_threads) {
+    size_t depth{}, q_tasks{1};
+    while (depth < q_phases && q_tasks < 4 * q_threads)
+        q_tasks *= q_phases - depth++;
+    return depth;
+}
+
+inline size_t get_search_threads() {
+    return max(1u, thread::hardware_concurrency());
+}
+
+// runs work(task) for every task on q_threads threads, each one keeping its own best result
+template <typename Task, typename Work>
+int64_t get_parallel_max(const vector<Task> &tasks, size_t q_threads, Work work) {
+    atomic<size_t> next_task{};
+    vector<int64_t> best(q_threads, numeric_limits<int64_t>::min());
+
+    auto worker = [&](size_t thread_id) {
+        for (size_t task; (task = next_task.fetch_add(1, memory_order_relaxed)) < tasks.size(); )
+            best[thread_id] = max(best[thread_id], work(tasks[task]));
+    };
+
+    vector<thread> threads;
+    for (size_t i{1}; i<q_threads; ++i)
+        threads.emplace_back(worker, i);
+    worker(0);
+    for (auto &t: threads)
+        t.join();
+
+    return *max_element(best.begin(), best.end());
+}
+
+// every ordering of k phases out of the given ones, each with the phases left over after it
+inline void get_prefixes(vector<Phase> &prefix, vector<Phase> &left, size_t k, vector<pair<vector<Phase>, vector<Phase>>> &prefixes) {
+    if (prefix.size() == k) {
+        prefixes.emplace_back(prefix, left);
+        return;
+    }
+    for (size_t i{}; i<left.size(); ++i) {
+        Phase phase = left[i];
+        prefix.push_back(phase);
+        left.erase(left.begin() + i);
+        get_prefixes(prefix, left, k, prefixes);
+        left.insert(left.begin() + i, phase);
+        prefix.pop_back();
+    }
+}
+
+
+// the highest evaluate(ordering) over every ordering of the phases; evaluate must be safe to
+// call from several threads at once
+template <typename Evaluate>
+int64_t get_max_over_permutations(vector<Phase> phases, Evaluate evaluate, size_t q_threads = get_search_threads()) {
+    sort(phases.begin(), phases.end());
+    vector<pair<vector<Phase>, vector<Phase>>> prefixes;
+    vector<Phase> prefix;
+    get_prefixes(prefix, phases, get_split_depth(phases.size(), q_threads), prefixes);
+
+    return get_parallel_max(prefixes, q_threads, [&](const pair<vector<Phase>, vector<Phase>> &task) {
+        vector<Phase> ordering{task.first};
+        ordering.insert(ordering.end(), task.second.begin(), task.second.end());
+        int64_t best{numeric_limits<int64_t>::min()};
+        do {
+            best = max(best, evaluate(ordering));
+        } while (next_permutation(ordering.begin() + task.first.size(), ordering.end()));
+        return best;
+    });
+}
+
+
+// a feed forward chain: stage(phase, signal) is what a stage set to that phase outputs for the
+// signal it gets, and an ordering's result is what its last stage outputs. orderings sharing a
+// prefix share the signal coming out of it, so walking the trie of prefixes runs the stage at
+// depth k once per prefix of length k + 1, the first stage once per phase instead of once per
+// ordering
+template <typename Stage>
+int64_t get_max_over_chains(const vector<Phase> &phases, int64_t signal, Stage stage, size_t q_threads = get_search_threads()) {
+    struct Node {
+        vector<Phase> left;
+        int64_t signal;
+    };
+
+    // breadth first down to the split depth, on this thread
+    vector<Node> frontier{{phases, signal}};
+    for (size_t depth{get_split_depth(phases.size(), q_threads)}; depth; --depth) {
+        vector<Node> deeper;
+        for (const Node &node: frontier) {
+            for (size_t i{}; i<node.left.size(); ++i) {
+                Node child{node.left, stage(node.left[i], node.signal)};
+                child.left.erase(child.left.begin() + i);
+                deeper.push_back(move(child));
+            }
+        }
+        frontier = move(deeper);
+    }
+
+    // then depth first below each node of the frontier
+    auto walk = [&stage](auto &walk, vector<Phase> &left, int64_t signal) -> int64_t {
+        if (left.empty())
+            return signal;
+        int64_t best{numeric_limits<int64_t>::min()};
+        for (size_t i{}; i<left.size(); ++i) {
+            Phase phase = left[i];
+            int64_t output = stage(phase, signal);
+            left.erase(left.begin() + i);
+            best = max(best, walk(walk, left, output));
+            left.insert(left.begin() + i, phase);
+        }
+        return best;
+    };
+
+    return get_parallel_max(frontier, q_threads, [&walk](const Node &node) {
+        vector<Phase> left{node.left};
+        return walk(walk, left, node.signal);
+    });
+}
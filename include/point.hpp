@@ -1,5 +1,9 @@
+#pragma once
+
 #include <algorithm>
 #include <array>
+#include <functional>
+#include <ostream>
 
 using namespace std;
 
@@ -38,8 +42,8 @@ struct PointHasher
 
 std::ostream &operator<<(std::ostream &, const Point &p);
 
-auto cmp_point = [](const Point& a, const Point& b){
+inline const auto cmp_point = [](const Point& a, const Point& b){
     return a.y < b.y || (a.y == b.y && a.x < b.x);
 };
 
-static const array<Point, 4> directions{Point{1, 0}, Point{0, 1}, Point{-1, 0}, Point{0, -1}};
+inline const array<Point, 4> directions{Point{1, 0}, Point{0, 1}, Point{-1, 0}, Point{0, -1}};
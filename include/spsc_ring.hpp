@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread.
+// capacity must be a power of two; head and tail only grow and wrap through the mask
+template <typename T, size_t CAPACITY = 64>
+class SpscRing {
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of two");
+
+    public:
+
+    bool try_push(const T &value) {
+        const size_t tail_ = tail.load(memory_order_relaxed);
+        if (tail_ - head.load(memory_order_acquire) == CAPACITY)
+            return false;
+
+        slots[tail_ & (CAPACITY - 1)] = value;
+        tail.store(tail_ + 1, memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &value) {
+        const size_t head_ = head.load(memory_order_relaxed);
+        if (head_ == tail.load(memory_order_acquire))
+            return false;
+
+        value = slots[head_ & (CAPACITY - 1)];
+        head.store(head_ + 1, memory_order_release);
+        return true;
+    }
+
+    // blocking versions, spinning politely so the other side gets to run
+    void push(const T &value) {
+        while (!try_push(value))
+            this_thread::yield();
+    }
+
+    T pop() {
+        T value;
+        while (!try_pop(value))
+            this_thread::yield();
+        return value;
+    }
+
+    private:
+
+    array<T, CAPACITY> slots;
+    // keep producer and consumer counters on separate cache lines
+    alignas(64) atomic<size_t> head{0};
+    alignas(64) atomic<size_t> tail{0};
+};
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <stdexcept>
+
+#include "day11_lib.hpp"
+
+using namespace std;
+
+
+void HullBrush::print() {
+    if (panels.empty())
+        return;
+
+    // north up
+    for (int y{panels.get_max().y}; y>=panels.get_min().y; y--) {
+        const char *row = panels.row(y);
+        for (int x{panels.get_min().x}; x<=panels.get_max().x; x++)
+            cout << (*row++ == '#' ? '#' : ' ');
+        cout << endl;
+    }
+}
+
+void HullBrush::paint(const bool color) {
+    panels[current_position] = color ? '#' : '.';
+}
+
+void HullBrush::step() {
+    current_position += current_direction;
+}
+
+void HullBrush::turn(const bool right) {
+    // previously heading north
+    if (current_direction == Point{0,1})
+        current_direction = right ? Point{1,0} : Point{-1,0};
+
+    // south
+    else if (current_direction == Point{0,-1})
+        current_direction = right ? Point{-1,0} : Point{1,0};
+
+    // west
+    else if (current_direction == Point{-1,0})
+        current_direction = right ? Point{0,1} : Point{0,-1};
+
+    // east
+    else if (current_direction == Point{1,0})
+        current_direction = right ? Point{0,-1} : Point{0,1};
+
+    else
+        throw runtime_error("invalid direction");
+}
+
+bool HullBrush::is_current_position_white() const {
+    return panels.at(current_position) == '#';
+}
+
+size_t HullBrush::count_painted_positions() const {
+    return panels.count_if([](char panel) { return panel != ' '; });
+}
+
+
+void paint_hull(IntcodeComputer &computer, HullBrush &brush) {
+    while (!computer.has_terminated()) {
+        computer.push_input(brush.is_current_position_white() ? 1 : 0);
+        computer.run();
+        brush.paint(computer.pop_output() == 1);
+        brush.turn(computer.pop_output() == 1);
+        brush.step();
+    }
+}
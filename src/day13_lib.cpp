@@ -0,0 +1,103 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include "day13_lib.hpp"
+
+using namespace std;
+
+
+void Arkanoid::refresh_screen() {
+
+    // some black magic to clear the screen
+    cout << "\033[2J\033[1;1H";
+
+    // row by row, from the top
+    if (!field.empty()) {
+        const size_t width = field.get_max().x - field.get_min().x + 1;
+        for (int y{field.get_min().y}; y<=field.get_max().y; ++y)
+            cout.write(field.row(y), width) << endl;
+    }
+    cout << "Amount of blocks: " << q_blocks << endl;
+    cout << "Current score: " << current_score << endl;
+}
+
+void Arkanoid::process_computer_output(Value value) {
+    // gather three-outputs sequences
+    command[q_command++] = value;
+    if (q_command < command.size())
+        return;
+    q_command = 0;
+
+    const auto [x, y, output] = command;
+
+    // special coords for score
+    if (x == -1 && y == 0) {
+        current_score = output;
+    }
+    // coords representing field state
+    else {
+        Point point{static_cast<int>(x), static_cast<int>(y)};
+        char c;
+        switch (output) {
+            case 0: c = ' '; break; // space
+            case 1: c = '#'; break; // wall
+
+            // block
+            case 2:
+                c = '*';
+                q_blocks++;
+                break;
+
+            // paddle
+            case 3:
+                c = '@';
+                pad_position = point;
+                break;
+
+            // ball
+            case 4:
+                c = 'o';
+                ball_position = point;
+                break; // ball
+
+            default: throw runtime_error("Invalid object");
+        }
+
+        field[point] = c;
+    }
+}
+
+void Arkanoid::auto_play(bool on_screen) {
+    // analyze what she says as she says it
+    const OutputSink draw = [this](Value value) { process_computer_output(value); };
+    Value joystick{};
+    size_t q_joystick{};
+
+    while (true) {
+        // ball on intcode side
+        computer.run(&joystick, q_joystick, draw);
+
+        if (on_screen) {
+            // tell it to the user
+            refresh_screen();
+
+            // delay so you can see it
+            this_thread::sleep_for(chrono::milliseconds{10});
+        }
+
+        // game over?
+        if (computer.has_terminated())
+            break;
+
+        // move joystick to follow the ball
+        if (pad_position.x < ball_position.x)
+            joystick = 1;
+        else if (pad_position.x > ball_position.x)
+            joystick = -1;
+        else
+            joystick = 0;
+        q_joystick = 1;
+    }
+}
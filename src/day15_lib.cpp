@@ -0,0 +1,98 @@
+#include <cassert>
+#include <stdexcept>
+#include <unordered_set>
+
+#include "day15_lib.hpp"
+
+
+using namespace std;
+
+using PositionSet = unordered_set<Point, PointHasher>;
+
+
+Value get_direction_code(const Point &point) {
+    if (point == Point{0,1}) return 1;
+    if (point == Point{-1,0}) return 3;
+    if (point == Point{0,-1}) return 2;
+    if (point == Point{1,0}) return 4;
+    throw runtime_error("Invalid direction");
+};
+
+
+Value try_direction(IntcodeComputer &computer, const Point &direction) {
+    // try movement in a copy of the computer
+    computer.push_input(get_direction_code(direction));
+    computer.run();
+    assert(computer.output_size() == 1);
+    return computer.pop_output();
+}
+
+uint64_t map_section(const IntcodeComputer &computer, const Point &position, Section &section) {
+    // recursively try all four directions from position in the computer, without repeating positions
+    // keep track of positions in section and tank as a desirable side-effect
+    uint64_t q_instructions{};
+
+    // try all four directions
+    for (const auto &direction: directions) {
+        const auto landing_position = position + direction;
+
+        // visited, don't go further
+        if (section.map.at(landing_position) != ' ')
+            continue;
+
+        // not visited, fork computer and see what she says
+        auto computer_copy = computer.fork();
+        Value status = try_direction(computer_copy, direction);
+        q_instructions += computer_copy.instructions_executed() - computer.instructions_executed();
+        switch (status) {
+            // wall, don't go further
+            case 0:
+                section.map[landing_position] = '#';
+                continue;
+
+            // found the tank
+            case 2:
+                section.tank_position = landing_position;
+                // spillover to case 1
+
+            case 1:
+                // mark as visited (yes, also the tank)
+                section.map[landing_position] = '.';
+
+                // recurse
+                q_instructions += map_section(computer_copy, landing_position, section);
+        }
+    }
+    return q_instructions;
+}
+
+
+pair<size_t, size_t> compute_movements_and_minutes(const Section &section) {
+    PositionSet expanded;
+    PositionSet to_expand{section.tank_position};
+    size_t distance_to_tank{};
+    size_t i{};
+
+    while (!to_expand.empty()) {
+        PositionSet to_expand_copy{to_expand};
+        for (const auto position: to_expand_copy) {
+            // don't come here again
+            expanded.insert(position);
+            to_expand.erase(position);
+
+            // check for distance to tank (note we are going from tank to origin)
+            if (position == Point{})
+                distance_to_tank = i;
+
+            // add adjacent, unexpanded positions to expand set
+            for (const auto &direction: directions) {
+                const Point landing_position{position + direction};
+                if (!expanded.count(landing_position) && section.map.at(position) == '.')
+                    to_expand.insert(landing_position);
+            }
+        }
+        ++i;
+    }
+
+    return {distance_to_tank, i-1};
+}
@@ -6,6 +6,8 @@
 #include <vector>
 #include <algorithm>
 
+#include "parse.hpp"
+
 using namespace std;
 
 
@@ -79,19 +81,6 @@ vector<int> fft(const vector<int> &digits, const size_t q_phases) {
 }
 
 
-vector<int> parse_digits(const char *filename) {
-    ifstream file{filename};
-    assert(file.is_open());
-    char digit;
-    vector<int> digits;
-
-    while (file >> digit) {
-        digits.push_back(digit - '0');
-    }
-
-    return digits;
-}
-
 inline vector<int> repeat(const vector<int> &input, const size_t n) {
     vector<int> output(input.size() * n);
     for (size_t i{}; i<n; ++i)
@@ -7,15 +7,17 @@
 #include <fstream>
 #include <numeric>
 #include <string>
-#include <unordered_set>
 
+#include "grid.hpp"
 #include "point.hpp"
 #include "intcode.hpp"
+#include "parse.hpp"
 
 
 using namespace std;
 
-using PositionSet = unordered_set<Point, PointHasher>;
+// scaffolding as the camera draws it, empty space and anything off camera being '.'
+using Field = Grid<char>;
 using Routine = string;
 
 class Scaffold {
@@ -34,6 +36,7 @@ class Scaffold {
 
     private:
     void map_scaffold(IntcodeComputer &);
+    inline bool is_scaffold(const Point &) const;
     inline bool is_intersection(const Point &);
     void build_roadmap();
     bool generate_main();
@@ -42,7 +45,7 @@ class Scaffold {
     bool fit_b();
     void print() const;
 
-    PositionSet field;
+    Field field{'.'};
     Point current_position;
     Point current_direction;
     size_t roadmap_len;
@@ -57,7 +60,7 @@ bool Scaffold::turn()
 {
     // try left
     Point new_direction = current_direction.left();
-    if (field.count(current_position + new_direction)) {
+    if (is_scaffold(current_position + new_direction)) {
         current_direction = new_direction;
         roadmap.push_back('L');
         return true;
@@ -65,7 +68,7 @@ bool Scaffold::turn()
 
     // try right
     new_direction = current_direction.right();
-    if (field.count(current_position + new_direction)) {
+    if (is_scaffold(current_position + new_direction)) {
         current_direction = new_direction;
         roadmap.push_back('R');
         return true;
@@ -216,7 +219,7 @@ void Scaffold::generate_routines() {
 void Scaffold::forward()
 {
     int i{};
-    while (field.count(current_position + current_direction)) {
+    while (is_scaffold(current_position + current_direction)) {
         current_position += current_direction;
         ++i;
         roadmap.push_back('F');
@@ -231,110 +234,86 @@ void Scaffold::map_scaffold(IntcodeComputer &computer)
 
     int x{}, y{};
 
-    while (!computer.has_terminated()) {
-        computer.run();
-        while (computer.output_size()) {
-            Value v = computer.pop_output();
-            char c = static_cast<char>(v);
-
-            cout << c;
-
-            // end of line
-            if (c == '\n') {
-                --y;
-                x = 0;
+    // the whole view in one go, anything after it that isn't text stays queued
+    computer.run();
+    string view;
+    computer.drain_text(view);
+    cout << view;
+
+    for (char c: view) {
+        // end of line
+        if (c == '\n') {
+            --y;
+            x = 0;
+        }
+        // empty space
+        else if (c == '.') {
+            ++x;
+        }
+        // scaffold
+        else {
+            Point p{x, y};
+            ++x;
+            field[p] = c;
+
+            // ^, >, v or <
+            if (c == '^') {
+                current_direction = Point(0,1);
+                current_position = p;
             }
-            // empty space
-            else if (c == '.') {
-                ++x;
+            else if (c == '>') {
+                current_direction = Point(1,0);
+                current_position = p;
             }
-            // scaffold
-            else {
-                Point p{x, y};
-                ++x;
-                field.insert(p);
-
-                // ^, >, v or <
-                if (c == '^') {
-                    current_direction = Point(0,1);
-                    current_position = p;
-                }
-                else if (c == '>') {
-                    current_direction = Point(1,0);
-                    current_position = p;
-                }
-                else if (c == 'v') {
-                    current_direction = Point(0,-1);
-                    current_position = p;
-                }
-                else if (c == '<') {
-                    current_direction = Point(-1,0);
-                    current_position = p;
-                }
-                else
-                    cout << "Dust " << v << endl;
+            else if (c == 'v') {
+                current_direction = Point(0,-1);
+                current_position = p;
+            }
+            else if (c == '<') {
+                current_direction = Point(-1,0);
+                current_position = p;
             }
         }
     }
 }
 
 
+inline bool Scaffold::is_scaffold(const Point &position) const
+{
+    return field.at(position) != '.';
+}
+
 inline bool Scaffold::is_intersection(const Point &position)
 {
     return (
-        field.count(position + Point{0,1}) &&
-        field.count(position + Point{0,-1}) &&
-        field.count(position + Point{1,0}) &&
-        field.count(position + Point{-1,0})
+        is_scaffold(position + Point{0,1}) &&
+        is_scaffold(position + Point{0,-1}) &&
+        is_scaffold(position + Point{1,0}) &&
+        is_scaffold(position + Point{-1,0})
     );
 }
 
 int Scaffold::compute_sum_of_alignment_parameters()
 {
     int r{};
-    for (const auto &p: field)
-        if (is_intersection(p))
+    field.for_each([&](const Point &p, char c) {
+        if (c != '.' && is_intersection(p))
             r += p.x * abs(p.y);
+    });
 
     return r;
 }
 
-void enter_routine(IntcodeComputer &computer, const Routine &routine)
-{
-    for (size_t i{}; i<routine.size(); ++i)
-        computer.push_input(routine[i]);
-
-    computer.push_input(10); // \n
-}
-
-Text parse_csv_ints(const char *filename) {
-    fstream file;
-    file.open(filename);
-    assert(file.is_open());
-
-    string tp;
-    Value value;
-    Text integers;
-    while (getline(file, tp, ',')) {
-        stringstream ss(tp);
-        ss >> value;
-        integers.push_back(value);
-    }
-    file.close();
-
-    return integers;
-}
-
 int main(int argc, char **argv)
 {
-    Text text = parse_csv_ints(argv[argc - 1]);
+    Text text = parse_csv_ints<Value>(argv[argc - 1]);
     text[0] = 2;
     auto computer = IntcodeComputer(0, text);
-    enter_routine(computer, "A,B,B,C,C,A,A,B,B,C");
-    enter_routine(computer, "L,12,R,4,R,4");
-    enter_routine(computer, "R,12,R,4,L,12");
-    enter_routine(computer, "R,12,R,4,L,6,L,8,L,8");
-    enter_routine(computer, "n");
+    computer.push_line("A,B,B,C,C,A,A,B,B,C");
+    computer.push_line("L,12,R,4,R,4");
+    computer.push_line("R,12,R,4,L,12");
+    computer.push_line("R,12,R,4,L,6,L,8,L,8");
+    computer.push_line("n");
 
     Scaffold scaffold{computer};
 
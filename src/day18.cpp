@@ -14,12 +14,14 @@
 #include <map>
 #include <algorithm>
 
+#include "grid.hpp"
 #include "point.hpp"
 
 using namespace std;
 
 using PositionSet = unordered_set<Point, PointHasher>;
-using Field = map<Point, char, decltype(cmp_point)>;
+// anything past the edges reads as wall
+using Field = Grid<char>;
 using Letters = set<char>;
 using KeyPosition = map<char, Point>;
 
@@ -71,7 +73,7 @@ class Tunnel {
 };
 
 
-Tunnel::Tunnel(const char *filename) : field(cmp_point) {
+Tunnel::Tunnel(const char *filename) : field('#') {
     // parse file
     ifstream file{filename};
     assert(file.is_open());
@@ -210,7 +212,7 @@ Trace Tunnel::get_trace(const Point &start, const Point &target) const {
 void Tunnel::print(const Point &position, const Letters &available_keys) const {
     int y{};
     cout << endl;
-    for (const auto &[k, v]: field) {
+    field.for_each([&](const Point &k, char v) {
         if (k.y != y) {
             y = k.y;
             cout << endl;
@@ -222,7 +224,7 @@ void Tunnel::print(const Point &position, const Letters &available_keys) const {
             cout << '.';
         else
             cout << v;
-    }
+    });
     cout << endl;
     cout << "current position:" << field.at(position) << endl;
     cout << endl;
@@ -7,64 +7,54 @@
 
 #include "point.hpp"
 #include "intcode.hpp"
+#include "parse.hpp"
+#include "intcode_batch.hpp"
+#include "intcode_cache.hpp"
 
 
 using namespace std;
 
 
-Text parse_csv_ints(const char *filename) {
-    fstream file;
-    file.open(filename);
-    assert(file.is_open());
-
-    string tp;
-    Value value;
-    Text integers;
-    while (getline(file, tp, ',')) {
-        stringstream ss(tp);
-        ss >> value;
-        integers.push_back(value);
-    }
-    file.close();
-
-    return integers;
-}
-
-
-Value get_point_value(const Value x, const Value y, Text &text) {
-    auto computer = IntcodeComputer(0, text);
-    computer.push_input(x); // x
-    computer.push_input(y); // y
-    computer.run();
-    return computer.pop_output();
+// the edge tracing probes the same points over and over, only new ones run the drone program
+Value get_point_value(const Value x, const Value y, IntcodeRunCache &probes, uint64_t drone) {
+    return probes.run(drone, {x, y}).front();
 }
 
 
-inline bool is_lower_left_corner(const Value side, const Value x, const Value y, Text &text) {
-    return get_point_value(x, y, text) && get_point_value(x + side - 1, y - side + 1, text);
+inline bool is_lower_left_corner(const Value side, const Value x, const Value y, IntcodeRunCache &probes, uint64_t drone) {
+    return get_point_value(x, y, probes, drone) && get_point_value(x + side - 1, y - side + 1, probes, drone);
 }
 
 
 int main(int argc, char **argv)
 {
-    Text text = parse_csv_ints(argv[argc - 1]);
+    Text text = parse_csv_ints<Value>(argv[argc - 1]);
+    IntcodeRunCache probes{4096};
+    const uint64_t drone = probes.add(text);
 
     // make sure the functions work
-    assert(is_lower_left_corner(1, 0, 0, text) == true);
-    assert(is_lower_left_corner(2, 0, 0, text) == false);
-    assert(is_lower_left_corner(2, 11, 10, text) == true);
-    assert(is_lower_left_corner(2, 10, 9, text) == false);
-    assert(is_lower_left_corner(2, 11, 8, text) == false);
-    assert(is_lower_left_corner(2, 0, 8, text) == false);
-    assert(is_lower_left_corner(4, 33, 30, text) == true);
-    assert(is_lower_left_corner(4, 32, 30, text) == false);
-
-    // part 1
+    assert(is_lower_left_corner(1, 0, 0, probes, drone) == true);
+    assert(is_lower_left_corner(2, 0, 0, probes, drone) == false);
+    assert(is_lower_left_corner(2, 11, 10, probes, drone) == true);
+    assert(is_lower_left_corner(2, 10, 9, probes, drone) == false);
+    assert(is_lower_left_corner(2, 11, 8, probes, drone) == false);
+    assert(is_lower_left_corner(2, 0, 8, probes, drone) == false);
+    assert(is_lower_left_corner(4, 33, 30, probes, drone) == true);
+    assert(is_lower_left_corner(4, 32, 30, probes, drone) == false);
+
+    // part 1, probing all points at once
     {
+        const size_t side{50};
+        IntcodeBatch batch{text, side * side};
+        for (size_t lane{}; lane<batch.size(); ++lane) {
+            batch.push_input(lane, lane / side); // x
+            batch.push_input(lane, lane % side); // y
+        }
+        batch.run();
+
         Value q_affected{};
-        for (Value x{}; x<50; ++x)
-            for (Value y{}; y<50; ++y)
-                q_affected += get_point_value(x, y, text);
+        for (size_t lane{}; lane<batch.size(); ++lane)
+            q_affected += batch.pop_output(lane);
 
         cout << q_affected << " points affected\n";
     }
@@ -75,10 +65,10 @@ int main(int argc, char **argv)
         Value x{3}, y{4}, side{100};
 
         // trace the lower edge of the beam until it fits the square
-        while (!is_lower_left_corner(side, x, y, text)) {
+        while (!is_lower_left_corner(side, x, y, probes, drone)) {
             // cout << "Trying " << x << ',' << y << endl;
             ++y;
-            while (!get_point_value(x, y, text))
+            while (!get_point_value(x, y, probes, drone))
                 ++x;
         }
         // adjust y to yield the upper left corner
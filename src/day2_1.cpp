@@ -4,24 +4,9 @@
 #include <string>
 #include <vector>
 
-using namespace std;
-
+#include "parse.hpp"
 
-vector<int> parse_csv_ints(const char *filename) {
-    fstream file;
-    string tp;
-    vector<int> integers;
-    file.open(filename);
-    if (!file.is_open()) {
-        throw runtime_error(string("Unable to open file ") + string(filename));
-    }
-    while (getline(file, tp, ',')) {
-        integers.push_back(stoi(tp));
-    }
-    file.close();
-
-    return integers;
-}
+using namespace std;
 
 
 void print_intcode_program(vector<int> &intcode_program) {
@@ -56,7 +41,7 @@ void run_intcode_program(vector<int> &p) {
 
 
 int main(int argc, char **argv) {
-    vector<int> intcode_program = parse_csv_ints(argv[1]);
+    vector<int> intcode_program = parse_csv_ints<int>(argv[1]);
 
     intcode_program[1] = 12;
     intcode_program[2] = 2;
@@ -4,73 +4,38 @@
 #include <string>
 #include <vector>
 
+#include "intcode.hpp"
+#include "parse.hpp"
+#include "intcode_batch.hpp"
+#include "intcode_symbolic.hpp"
+
 using namespace std;
 
 
-vector<int> parse_csv_ints(const char *filename) {
-    fstream file;
-    file.open(filename);
-    if (!file.is_open()) {
-        throw runtime_error(string("Unable to open file ") + string(filename));
+int get_answer(const Text &text) {
+    // cell 0 as an expression of the noun and verb, solved rather than searched
+    try {
+        SymbolicRun run{text, {1, 2}};
+        auto noun_verb = run.solve(0, 19690720, {{0, 99}, {0, 99}});
+        if (!noun_verb.empty())
+            return 100 * noun_verb[0] + noun_verb[1];
     }
-
-    string tp;
-    vector<int> integers;
-    while (getline(file, tp, ',')) {
-        integers.push_back(stoi(tp));
+    catch (const runtime_error &) {
+        // branches on the noun or verb, or cell 0 reads through them, fall back to the search
     }
-    file.close();
-
-    return integers;
-}
-
 
-void print_intcode_program(vector<int> &intcode_program) {
-    for (auto i: intcode_program) {
-        cout << i << " ";
+    // try every noun and verb at once, one lane each
+    IntcodeBatch batch{text, 100 * 100};
+    for (size_t lane{}; lane<batch.size(); ++lane) {
+        batch.set(lane, 1, lane / 100); // noun
+        batch.set(lane, 2, lane % 100); // verb
     }
-    cout << endl;
-}
-
-
-void run_intcode_program(vector<int> &p) {
-
-    for (size_t i{}; i<p.size(); i+=4) {
-
-        switch (p[i]) {
-            case 1:
-                p[p[i+3]] = p[p[i+1]] + p[p[i+2]];
-                break;
-
-            case 2:
-                p[p[i+3]] = p[p[i+1]] * p[p[i+2]];
-                break;
-
-            case 99:
-                return;
-
-            default:
-                throw runtime_error("Invalid opcode");
-        }
-    }
-}
-
-
-int get_answer(vector<int> &p) {
-    for (int noun{}; noun<100; noun++) {
-        for (int verb{}; verb<100; verb++) {
-            // reset the memory
-            vector<int> p_copy = p;
-
-            // try noun and verb
-            p_copy[1] = noun;
-            p_copy[2] = verb;
-            run_intcode_program(p_copy);
+    batch.run();
 
-            // found it
-            if (p_copy[0] == 19690720) {
-                return 100 * noun + verb;
-            }
+    for (size_t lane{}; lane<batch.size(); ++lane) {
+        // found it, the lane number is 100 * noun + verb
+        if (batch.get(lane, 0) == 19690720) {
+            return lane;
         }
     }
 
@@ -79,7 +44,7 @@ int get_answer(vector<int> &p) {
 
 
 int main(int argc, char **argv) {
-    vector<int> intcode_program = parse_csv_ints(argv[1]);
-    cout << "And the winner is: " << get_answer(intcode_program) << endl;
+    Text text = parse_csv_ints<Value>(argv[1]);
+    cout << "And the winner is: " << get_answer(text) << endl;
     return 0;
 }
@@ -0,0 +1,14 @@
+#include "day5_lib.hpp"
+
+using namespace std;
+
+
+vector<Value> run_diagnostic(IntcodeComputer &computer, Value system_id) {
+    computer.push_input(system_id);
+    computer.run();
+
+    vector<Value> outputs;
+    while (computer.output_size())
+        outputs.push_back(computer.pop_output());
+    return outputs;
+}
@@ -0,0 +1,126 @@
+#include <map>
+#include <memory>
+#include <thread>
+
+#include "day7_lib.hpp"
+#include "phase_search.hpp"
+#include "spsc_ring.hpp"
+
+using namespace std;
+
+
+static void count_instructions(atomic<uint64_t> *q_instructions, const IntcodeComputer &computer) {
+    if (q_instructions)
+        q_instructions->fetch_add(computer.instructions_executed(), memory_order_relaxed);
+}
+
+
+Value amplify(IntcodeComputer &amplifier, Value signal) {
+    amplifier.push_input(signal);
+    amplifier.run();
+    return amplifier.pop_output();
+}
+
+
+Value get_series_thruster_signal(const Text &text, const vector<Value> &phases, atomic<uint64_t> *q_instructions) {
+    Value signal = 0;
+    for (auto phase_setting: phases) {
+        // fresh intcode program
+        IntcodeComputer amplifier{0, text};
+        amplifier.push_input(phase_setting);
+        signal = amplify(amplifier, signal);
+        count_instructions(q_instructions, amplifier);
+    }
+
+    return signal;
+}
+
+
+Value get_max_series_thruster_signal(const Text &text, const vector<Value> &phases, atomic<uint64_t> *q_instructions) {
+    // one amplifier per phase already past reading it, waiting for its signal
+    map<Value, IntcodeComputer> primed;
+    for (auto phase_setting: phases) {
+        auto &amplifier = primed.emplace(phase_setting, IntcodeComputer{0, text}).first->second;
+        amplifier.push_input(phase_setting);
+        amplifier.run();
+        count_instructions(q_instructions, amplifier);
+    }
+
+    // orderings sharing their first amplifiers share the signal coming out of them
+    return get_max_over_chains(phases, 0, [&primed, q_instructions](Value phase_setting, Value signal) {
+        const auto &start = primed.at(phase_setting);
+        auto amplifier = start.fork();
+        Value output = amplify(amplifier, signal);
+        if (q_instructions)
+            q_instructions->fetch_add(amplifier.instructions_executed() - start.instructions_executed(), memory_order_relaxed);
+        return output;
+    });
+}
+
+
+Value get_feedback_thruster_signal(const Text &text, vector<Value> &phases, atomic<uint64_t> *q_instructions) {
+    vector<IntcodeComputer> programs;
+    for (int i{}; i<5; i++) {
+        // each program with its own text copy
+        programs.emplace_back(i, text);
+        programs.back().push_input(phases[i]);
+    }
+
+    int i{};
+    Value signal{};
+
+    // do round-robin until E Amp program halts
+    do {
+        signal = amplify(programs[i % 5], signal);
+        i++;
+    }
+    while (!programs[4].has_terminated());
+
+    for (const auto &program: programs)
+        count_instructions(q_instructions, program);
+
+    // last output of 5th program
+    return signal;
+}
+
+
+Value get_feedback_thruster_signal_pipelined(const Text &text, vector<Value> &phases, atomic<uint64_t> *q_instructions) {
+    // one thread per amplifier, each reading from its own ring and writing into the next one's,
+    // with the last one feeding back into the first
+    const size_t q_amplifiers{phases.size()};
+    vector<IntcodeComputer> programs;
+    vector<unique_ptr<SpscRing<Value>>> rings;
+    for (size_t i{}; i<q_amplifiers; i++) {
+        programs.emplace_back(i, text);
+        programs.back().push_input(phases[i]);
+        rings.push_back(make_unique<SpscRing<Value>>());
+    }
+
+    // initial signal
+    rings[0]->push(0);
+
+    vector<thread> threads;
+    for (size_t i{}; i<q_amplifiers; i++) {
+        threads.emplace_back([&program = programs[i], &in = *rings[i], &out = *rings[(i + 1) % q_amplifiers]]() {
+            while (!program.has_terminated())
+                out.push(amplify(program, in.pop()));
+        });
+    }
+
+    for (auto &t: threads)
+        t.join();
+
+    for (const auto &program: programs)
+        count_instructions(q_instructions, program);
+
+    // last output of the last amplifier, waiting in the first one's ring as nobody is left to read it
+    return rings[0]->pop();
+}
+
+
+Value get_max_feedback_thruster_signal(const Text &text, vector<Value> &phases, SignalFunction get_signal, atomic<uint64_t> *q_instructions) {
+    // every phase permutation, spread over as many threads as there are cores
+    return get_max_over_permutations(phases, [&text, get_signal, q_instructions](vector<Value> &ordering) {
+        return get_signal(text, ordering, q_instructions);
+    });
+}
@@ -7,21 +7,9 @@
 #include <tuple>
 #include <limits>
 
-using namespace std;
-
+#include "parse.hpp"
 
-vector<int> parse_digits(const char *filename) {
-    ifstream file{filename};
-    assert(file.is_open());
-    char digit;
-    vector<int> digits;
-
-    while (file >> digit) {
-        digits.push_back(digit - '0');
-    }
-
-    return digits;
-}
+using namespace std;
 
 
 class Image {
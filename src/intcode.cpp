@@ -1,52 +1,266 @@
+#include <algorithm>
 #include <cassert>
-#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <queue>
 #include <vector>
-#include <sstream>
 #include <fstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "intcode.hpp"
+#include "parse.hpp"
 
 
 using namespace std;
 
 
-Memory::Memory(Text &text) {
-    this->text = text;
+Instruction Instruction::decode(Value word) {
+    Instruction instruction;
+    instruction.opcode = word % 100;
+    instruction.modes = {
+        static_cast<int>((word / 100) % 10),
+        static_cast<int>((word / 1000) % 10),
+        static_cast<int>((word / 10000) % 10)
+    };
+    instruction.decoded = true;
+
+    switch (instruction.opcode) {
+        case 1: case 2: case 7: case 8:
+            instruction.q_params = 3;
+            break;
+
+        case 5: case 6:
+            instruction.q_params = 2;
+            break;
+
+        case 3: case 4: case 9:
+            instruction.q_params = 1;
+            break;
+
+        // halt, or invalid which is reported upon execution
+        default:
+            instruction.q_params = 0;
+    }
+    instruction.span = instruction.q_params;
+    instruction.forward_result = false;
+
+    if (instruction.opcode >= 1 && instruction.opcode <= 9)
+        instruction.handler = instruction.opcode;
+    else if (instruction.opcode == 99)
+        instruction.handler = 10;
+    else
+        instruction.handler = 0;
+
+    return instruction;
+}
+
+
+Memory::Memory(Text &text) : text_size(text.size()) {
+    // straight into the pages, nothing is decoded yet and loading isn't a program write
+    for (size_t address{}; address<text.size(); ++address)
+        writable_page(address >> PAGE_BITS)[address & (PAGE_SIZE - 1)] = text[address];
 }
 
 void Memory::print() {
     cout << "Text" << endl;
-    for (auto i: text) {
-        cout << i << " ";
+    for (size_t address{}; address<text_size; ++address) {
+        cout << get(address) << " ";
     }
     cout << endl;
     cout << "Heap" << endl;
-    for (auto &[k, v]: heap) {
+    for (size_t page{}; page<pages.size(); ++page) {
+        if (!pages[page])
+            continue;
+        for (Address offset{}; offset<PAGE_SIZE; ++offset) {
+            Address address = (page << PAGE_BITS) + offset;
+            if (static_cast<size_t>(address) >= text_size && (*pages[page])[offset])
+                cout << address << " : " << (*pages[page])[offset] << endl;
+        }
+    }
+    for (auto &[k, v]: far_heap) {
         cout << k << " : " << v << endl;;
     }
 }
 
+Page &Memory::writable_page(size_t page) {
+    if (page >= pages.size())
+        pages.resize(page + 1);
+
+    auto &p = pages[page];
+    if (!p)
+        p = make_shared<Page>();
+    else if (p.use_count() > 1)
+        // shared with a fork, copy on write
+        p = make_shared<Page>(*p);
+
+    return *p;
+}
+
+DecodedPage &Memory::writable_decoded_page(size_t page) {
+    if (page >= decoded.size())
+        decoded.resize(page + 1);
+
+    auto &p = decoded[page];
+    if (!p)
+        p = make_shared<DecodedPage>();
+    else if (p.use_count() > 1)
+        p = make_shared<DecodedPage>(*p);
+
+    return *p;
+}
+
+void Memory::invalidate_decoded(size_t page, Address offset) {
+    if (page >= decoded.size() || !decoded[page] || !decoded[page]->covered[offset])
+        return;
+
+    // self-modifying code, decode again any instruction overlapping the offset
+    for (Address a{max(Address{}, offset - MAX_INSTRUCTION_SPAN)}; a<=offset; ++a) {
+        const Instruction &instruction = decoded[page]->instructions[a];
+        if (instruction.decoded && a + instruction.span >= offset)
+            writable_decoded_page(page).instructions[a].decoded = false;
+    }
+}
+
 void Memory::set(Address address, Value value) {
     assert(address >= 0);
-    if (static_cast<size_t>(address) < text.size()) {
-        text[address] = value;
+    size_t page = address >> PAGE_BITS;
+    Address offset = address & (PAGE_SIZE - 1);
+
+#ifdef INTCODE_PROFILE
+    if (static_cast<size_t>(address) < text_size)
+        ++profile.q_text_writes;
+    else
+        ++profile.q_heap_writes;
+#endif
+
+    if (page < MAX_PAGES) {
+        // fast path for pages this computer owns alone
+        if (page < pages.size() && pages[page] && pages[page].use_count() == 1)
+            (*pages[page])[offset] = value;
+        else
+            writable_page(page)[offset] = value;
+        invalidate_decoded(page, offset);
+#ifdef INTCODE_JIT
+        if (jit)
+            invalidate_compiled(address);
+#endif
     }
     else {
-        heap[address] = value;
+        far_heap[address] = value;
     }
 }
 
 Value Memory::get(Address address) {
     assert(address >= 0);
-    if (static_cast<size_t>(address) < text.size()) {
-        return text.at(address);
+    size_t page = address >> PAGE_BITS;
+
+#ifdef INTCODE_PROFILE
+    if (static_cast<size_t>(address) < text_size)
+        ++profile.q_text_reads;
+    else
+        ++profile.q_heap_reads;
+#endif
+
+    if (page < pages.size()) {
+        return pages[page] ? (*pages[page])[address & (PAGE_SIZE - 1)] : 0;
+    }
+    else if (page < MAX_PAGES) {
+        // never written
+        return 0;
     }
     else {
-        return heap[address];
+        auto it = far_heap.find(address);
+        return it == far_heap.end() ? 0 : it->second;
+    }
+}
+
+// Superinstructions: an add or a compare followed by a conditional jump, the
+// usual shape of a loop test, runs as one dispatch. The jump stays cached in
+// its own slot four words on, so the pair must sit within one page.
+void Memory::fuse(Address address) {
+    size_t page = address >> PAGE_BITS;
+    Address offset = address & (PAGE_SIZE - 1);
+    if (offset + MAX_INSTRUCTION_SPAN >= PAGE_SIZE)
+        return;
+
+    Instruction &head = writable_decoded_page(page).instructions[offset];
+    if (head.opcode != 1 && head.opcode != 7 && head.opcode != 8)
+        return;
+
+    // only a jump is decoded ahead, and on its own: a head there is fused once it's fetched itself,
+    // rather than chaining through every head that follows
+    const Instruction *cached_jump = cached(address + 4);
+    if (!cached_jump) {
+        Value opcode = get(address + 4) % 100;
+        if (opcode != 5 && opcode != 6)
+            return;
+    }
+    const Instruction &jump = cached_jump ? *cached_jump : translate(address + 4);
+    if (jump.opcode != 5 && jump.opcode != 6)
+        return;
+
+    // a position mode write to the jump's own words would leave it stale
+    if (head.modes[2] == 0 && head.params[2] >= address + 4 && head.params[2] <= address + 6)
+        return;
+
+    head.handler = head.opcode == 1 ? 11 : head.opcode == 7 ? 12 : 13;
+    head.span = MAX_INSTRUCTION_SPAN;
+    // same address both ways, and nothing runs in between to move the relative base
+    head.forward_result = head.opcode != 1 && jump.modes[0] == head.modes[2] && jump.modes[0] != 1 &&
+                          jump.params[0] == head.params[2];
+}
+
+const Instruction *Memory::cached(Address address) const {
+    size_t page = address >> PAGE_BITS;
+    Address offset = address & (PAGE_SIZE - 1);
+    if (page < decoded.size() && decoded[page] && decoded[page]->instructions[offset].decoded)
+        return &decoded[page]->instructions[offset];
+    return nullptr;
+}
+
+const Instruction &Memory::fetch(Address address) {
+    assert(address >= 0);
+    if (const Instruction *instruction = cached(address))
+        return *instruction;
+
+    const Instruction &translated = translate(address);
+    if (&translated != &decoded_uncached)
+        fuse(address);
+    return translated;
+}
+
+// the instruction alone, into the cache where it fits
+const Instruction &Memory::translate(Address address) {
+    size_t page = address >> PAGE_BITS;
+    Address offset = address & (PAGE_SIZE - 1);
+
+    Instruction translated = Instruction::decode(get(address));
+    for (int i{}; i<translated.q_params; ++i)
+        translated.params[i] = get(address + 1 + i);
+
+    if (page < MAX_PAGES && offset + translated.q_params < PAGE_SIZE) {
+        DecodedPage &decoded_page = writable_decoded_page(page);
+        for (Address a{offset}; a<=offset + translated.q_params; ++a)
+            decoded_page.covered[a] = true;
+#ifdef INTCODE_JIT
+        // compiled code stores straight into memory, except to watched words
+        if (jit)
+            watch_decoded(address, address + translated.q_params + 1);
+#endif
+        decoded_page.instructions[offset] = translated;
+        return decoded_page.instructions[offset];
     }
+
+    // straddling two pages or far away, not worth caching
+    decoded_uncached = translated;
+    return decoded_uncached;
 }
 
 
@@ -54,14 +268,59 @@ IntcodeComputer::IntcodeComputer(int id, Text text) : id(id), memory(text) {
     relative_base = 0;
     ip = 0;
     terminated = false;
+#ifdef INTCODE_JIT_ALWAYS
+    enable_jit();
+#endif
 }
 
-bool IntcodeComputer::has_terminated() {
-    return terminated;
+// a copy sharing every memory page with this computer until either of them writes to it
+IntcodeComputer IntcodeComputer::fork() const {
+    return *this;
 }
 
-inline int IntcodeComputer::parse_opcode(int instruction) {
-    return instruction % 100;
+// Nothing up to the first input read depends on the inputs, so a program run
+// many times over only needs it done once: fork the result for each run and
+// push that run's inputs. Outputs produced on the way stay queued and each
+// fork gets its own copy of them, as well as of the warm decode cache.
+IntcodeComputer IntcodeComputer::partially_evaluated(int id, Text text) {
+    IntcodeComputer computer{id, move(text)};
+    computer.run();
+    return computer;
+}
+
+size_t IntcodeComputer::run(const Value *inputs, size_t q_inputs, const OutputSink &sink) {
+    input_span = inputs;
+    input_span_end = inputs + q_inputs;
+    output_sink = &sink;
+    try {
+        run();
+    }
+    catch (...) {
+        input_span = input_span_end = nullptr;
+        output_sink = nullptr;
+        throw;
+    }
+
+    size_t q_taken = input_span - inputs;
+    input_span = input_span_end = nullptr;
+    output_sink = nullptr;
+    return q_taken;
+}
+
+uint64_t IntcodeComputer::instructions_executed() const {
+    return q_executed;
+}
+
+uint64_t IntcodeComputer::native_instructions_executed() const {
+#ifdef INTCODE_JIT
+    return q_native;
+#else
+    return 0;
+#endif
+}
+
+bool IntcodeComputer::has_terminated() {
+    return terminated;
 }
 
 size_t IntcodeComputer::output_size() {
@@ -74,43 +333,51 @@ Value IntcodeComputer::pop_output() {
     return aux;
 }
 
-int IntcodeComputer::parse_parameter_mode(int instruction, int parameter_offset) {
-    assert(parameter_offset <= 3);
-    uint32_t divisor = pow(10, parameter_offset + 1);
-    uint32_t  modulo = divisor * 10;
-
-    return (instruction % modulo) / divisor;
-}
+Value IntcodeComputer::get_read_param(const Instruction &instruction, int offset) {
+    assert(offset >= 1 && offset <= instruction.q_params);
+    int parameter_mode = instruction.modes[offset - 1];
 
-Value IntcodeComputer::get_read_param(int offset) {
-    int parameter_mode = parse_parameter_mode(memory.get(ip), offset);
+    Value param = instruction.params[offset - 1];
 
     // position
     if (parameter_mode == 0)
-        return memory.get(memory.get(ip+offset));
+        return memory.get(param);
 
     // immediate
     if (parameter_mode == 1)
-        return memory.get(ip+offset);
+        return param;
 
     // relative base
     if (parameter_mode == 2)
-        return memory.get(memory.get(ip+offset) + relative_base);
+        return memory.get(param + relative_base);
 
     throw runtime_error("Invalid parameter mode");
 }
 
-Address IntcodeComputer::get_write_address(int offset) {
-    int parameter_mode = parse_parameter_mode(memory.get(ip), offset);
+// second half of a superinstruction, with the ip still on the head
+inline void IntcodeComputer::fused_jump(const Instruction &head, Value result) {
+    const Instruction &jump = *(&head + 4);
+    Value condition = head.forward_result ? result : get_read_param(jump, 1);
+    if ((jump.opcode == 5) == (condition != 0))
+        ip = static_cast<Address>(get_read_param(jump, 2));
+    else
+        ip += 7;
+}
+
+Address IntcodeComputer::get_write_address(const Instruction &instruction, int offset) {
+    assert(offset >= 1 && offset <= instruction.q_params);
+    int parameter_mode = instruction.modes[offset - 1];
+
+    Value param = instruction.params[offset - 1];
 
     // position
     if (parameter_mode == 0) {
-        return memory.get(ip+offset);
+        return param;
     }
 
     // relative base
     if (parameter_mode == 2) {
-        return memory.get(ip+offset) + relative_base;
+        return param + relative_base;
     }
 
     throw runtime_error("Invalid write address mode");
@@ -124,120 +391,580 @@ void IntcodeComputer::push_input(Value value) {
     input.push(value);
 }
 
+void IntcodeComputer::push_line(string_view line) {
+    for (char c: line)
+        input.push(c);
+    input.push('\n');
+}
 
+size_t IntcodeComputer::drain_text(string &text) {
+    size_t q_appended{};
+    text.reserve(text.size() + output.size());
+    while (!output.empty() && output.front() >= 0 && output.front() < 128) {
+        text.push_back(static_cast<char>(output.front()));
+        output.pop();
+        ++q_appended;
+    }
+    return q_appended;
+}
+
+
+// either a comma separated text file or a compiled binary one
 IntcodeComputer IntcodeComputer::from_file(const int id, const char *filename) {
-    fstream file;
-    file.open(filename);
+    if (is_binary_program(filename))
+        return IntcodeComputer(id, read_binary_program(filename));
+    else
+        return IntcodeComputer(id, read_text_program(filename));
+}
+
+
+Text read_text_program(const char *filename) {
+    return parse_csv_ints<Value>(filename);
+}
+
+static const char BINARY_PROGRAM_MAGIC[4]{'I', 'C', 'B', 'N'};
+static const uint32_t BINARY_PROGRAM_VERSION{1};
+
+static bool is_little_endian() {
+    const uint16_t probe{1};
+    uint8_t first_byte;
+    memcpy(&first_byte, &probe, 1);
+    return first_byte == 1;
+}
+
+static uint64_t swap_bytes(uint64_t v) {
+    uint64_t r{};
+    for (int i{}; i<8; ++i, v >>= 8)
+        r = (r << 8) | (v & 0xff);
+    return r;
+}
+
+bool is_binary_program(const char *filename) {
+    ifstream file{filename, ios::binary};
     assert(file.is_open());
 
-    string tp;
-    Value value;
-    Text text;
-    while (getline(file, tp, ',')) {
-        stringstream ss(tp);
-        ss >> value;
-        text.push_back(value);
+    char magic[4]{};
+    file.read(magic, sizeof(magic));
+    return file && memcmp(magic, BINARY_PROGRAM_MAGIC, sizeof(magic)) == 0;
+}
+
+Text read_binary_program(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        throw runtime_error(string("Unable to open file ") + string(filename));
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(BinaryProgramHeader)) {
+        close(fd);
+        throw runtime_error(string("Invalid binary program ") + string(filename));
+    }
+
+    void *mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw runtime_error(string("Unable to map file ") + string(filename));
+
+    BinaryProgramHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    const bool valid = (
+        memcmp(header.magic, BINARY_PROGRAM_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == BINARY_PROGRAM_VERSION &&
+        header.value_width == sizeof(Value) &&
+        sizeof(header) + header.q_words * sizeof(Value) <= static_cast<size_t>(st.st_size)
+    );
+    if (!valid) {
+        munmap(mapped, st.st_size);
+        throw runtime_error(string("Invalid binary program ") + string(filename));
+    }
+
+    // no parsing, the payload already is the text
+    Text text(header.q_words);
+    memcpy(text.data(), static_cast<const char *>(mapped) + sizeof(header), header.q_words * sizeof(Value));
+    munmap(mapped, st.st_size);
+
+    if (!is_little_endian())
+        for (auto &word: text)
+            word = swap_bytes(word);
+
+    return text;
+}
+
+void write_binary_program(const Text &text, const char *filename) {
+    ofstream file{filename, ios::binary};
+    if (!file.is_open())
+        throw runtime_error(string("Unable to open file ") + string(filename));
+
+    BinaryProgramHeader header{};
+    memcpy(header.magic, BINARY_PROGRAM_MAGIC, sizeof(header.magic));
+    header.version = BINARY_PROGRAM_VERSION;
+    header.value_width = sizeof(Value);
+    header.q_words = text.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    Text words{text};
+    if (!is_little_endian())
+        for (auto &word: words)
+            word = swap_bytes(word);
+    file.write(reinterpret_cast<const char *>(words.data()), words.size() * sizeof(Value));
+}
+
+
+static const char SNAPSHOT_MAGIC[4]{'I', 'C', 'S', 'S'};
+static const uint32_t SNAPSHOT_VERSION{1};
+static const uint32_t SNAPSHOT_TERMINATED{1};
+// pages start on a boundary the OS can map them from
+static const size_t SNAPSHOT_PAGE_ALIGNMENT{4096};
+
+static void write_snapshot_word(ostream &file, Value word) {
+    if (!is_little_endian())
+        word = swap_bytes(word);
+    file.write(reinterpret_cast<const char *>(&word), sizeof(word));
+}
+
+// written aside and renamed over the file, so a crash midway leaves the previous snapshot
+// whole, and computers restored from it keep their mapping of the old one
+void IntcodeComputer::save(const char *filename) const {
+    const string partial = string(filename) + ".partial";
+    ofstream file{partial, ios::binary};
+    if (!file.is_open())
+        throw runtime_error(string("Unable to open file ") + partial);
+
+    vector<size_t> present;
+    for (size_t page{}; page<memory.pages.size(); ++page)
+        if (memory.pages[page])
+            present.push_back(page);
+
+    IntcodeSnapshotHeader header{};
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.value_width = sizeof(Value);
+    header.flags = terminated ? SNAPSHOT_TERMINATED : 0;
+    header.ip = ip;
+    header.relative_base = relative_base;
+    header.text_size = memory.text_size;
+    header.q_executed = q_executed;
+    header.q_pages = present.size();
+    header.q_far_words = memory.far_heap.size();
+    header.q_inputs = input.size();
+    header.q_outputs = output.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (auto page: present)
+        write_snapshot_word(file, page);
+    for (const auto &[address, value]: memory.far_heap) {
+        write_snapshot_word(file, address);
+        write_snapshot_word(file, value);
     }
+    for (auto pending: {input, output})
+        for (; !pending.empty(); pending.pop())
+            write_snapshot_word(file, pending.front());
+
+    const char padding[SNAPSHOT_PAGE_ALIGNMENT]{};
+    file.write(padding, (SNAPSHOT_PAGE_ALIGNMENT - file.tellp() % SNAPSHOT_PAGE_ALIGNMENT) % SNAPSHOT_PAGE_ALIGNMENT);
+    for (auto page: present)
+        for (auto word: *memory.pages[page])
+            write_snapshot_word(file, word);
+
     file.close();
+    if (!file || rename(partial.c_str(), filename) != 0) {
+        remove(partial.c_str());
+        throw runtime_error(string("Unable to write snapshot ") + string(filename));
+    }
+}
+
+IntcodeComputer IntcodeComputer::restore(const int id, const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1)
+        throw runtime_error(string("Unable to open file ") + string(filename));
 
-    return IntcodeComputer(id, text);
+    struct stat st;
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(IntcodeSnapshotHeader)) {
+        close(fd);
+        throw runtime_error(string("Invalid snapshot ") + string(filename));
+    }
+
+    // private and writable, but pages are copied on their first write anyway since
+    // they all share the mapping's use count
+    const size_t size = st.st_size;
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+        throw runtime_error(string("Unable to map file ") + string(filename));
+    // the pages pointing into the mapping keep it alive
+    shared_ptr<char> mapping{static_cast<char *>(mapped), [size](char *m) { munmap(m, size); }};
+
+    IntcodeSnapshotHeader header;
+    memcpy(&header, mapping.get(), sizeof(header));
+    const size_t max_words = size / sizeof(Value);
+    bool valid = (
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0 &&
+        header.version == SNAPSHOT_VERSION &&
+        header.value_width == sizeof(Value) &&
+        header.q_pages <= MAX_PAGES &&
+        header.q_far_words <= max_words && header.q_inputs <= max_words && header.q_outputs <= max_words
+    );
+    const size_t q_words = header.q_pages + 2 * header.q_far_words + header.q_inputs + header.q_outputs;
+    const size_t pages_offset = (sizeof(header) + q_words * sizeof(Value) + SNAPSHOT_PAGE_ALIGNMENT - 1) /
+                                SNAPSHOT_PAGE_ALIGNMENT * SNAPSHOT_PAGE_ALIGNMENT;
+    valid = valid && pages_offset + header.q_pages * sizeof(Page) <= size;
+    if (!valid)
+        throw runtime_error(string("Invalid snapshot ") + string(filename));
+
+    const char *words = mapping.get() + sizeof(header);
+    auto word = [&words]() {
+        Value w;
+        memcpy(&w, words, sizeof(w));
+        words += sizeof(w);
+        return is_little_endian() ? w : swap_bytes(w);
+    };
+
+    Text empty;
+    IntcodeComputer computer{id, empty};
+    computer.memory.text_size = header.text_size;
+    for (size_t i{}; i<header.q_pages; ++i) {
+        Value page = word();
+        if (page < 0 || static_cast<size_t>(page) >= MAX_PAGES)
+            throw runtime_error(string("Invalid snapshot ") + string(filename));
+        if (static_cast<size_t>(page) >= computer.memory.pages.size())
+            computer.memory.pages.resize(page + 1);
+
+        char *data = mapping.get() + pages_offset + i * sizeof(Page);
+        if (is_little_endian()) {
+            computer.memory.pages[page] = shared_ptr<Page>(mapping, reinterpret_cast<Page *>(data));
+        }
+        else {
+            auto copy = make_shared<Page>();
+            memcpy(copy->data(), data, sizeof(Page));
+            for (auto &w: *copy)
+                w = swap_bytes(w);
+            computer.memory.pages[page] = copy;
+        }
+    }
+    for (size_t i{}; i<header.q_far_words; ++i) {
+        Value address = word();
+        computer.memory.far_heap[address] = word();
+    }
+    for (size_t i{}; i<header.q_inputs; ++i)
+        computer.input.push(word());
+    for (size_t i{}; i<header.q_outputs; ++i)
+        computer.output.push(word());
+
+    computer.ip = header.ip;
+    computer.relative_base = header.relative_base;
+    computer.terminated = header.flags & SNAPSHOT_TERMINATED;
+    computer.q_executed = header.q_executed;
+    return computer;
 }
 
+// GCC and clang support labels as values, so each handler jumps straight to the next one
+// instead of going back through a single shared switch branch.
+// Build with -DINTCODE_SWITCH_DISPATCH to use the portable switch instead.
+#if defined(__GNUC__) && !defined(INTCODE_SWITCH_DISPATCH)
+#define INTCODE_THREADED_DISPATCH
+#endif
+
+#ifdef INTCODE_PROFILE
+#define PROFILE(statement) statement
+#else
+#define PROFILE(statement)
+#endif
+
+#ifdef INTCODE_THREADED_DISPATCH
+#define TARGET(handler, label) label:
+#define TARGET_INVALID invalid:
+#define DISPATCH() \
+    do { \
+        if (q_dispatched >= budget) { \
+            status = RunStatus::budget_exhausted; \
+            goto suspend; \
+        } \
+        instruction = &memory.fetch(ip); \
+        ++q_dispatched; \
+        PROFILE(memory.profile.count(*instruction, ip)); \
+        goto *dispatch_table[instruction->handler]; \
+    } while (0)
+#else
+#define TARGET(handler, label) case handler:
+#define TARGET_INVALID default:
+#define DISPATCH() continue
+#endif
 
 Value IntcodeComputer::run() {
-    // local state to break out of the main loop
-    bool runnable = true;
+    execute(numeric_limits<uint64_t>::max(), false);
+    // waiting on input before having output anything
+    if (output.empty())
+        return 0;
+    return output.front();
+}
 
-    // main loop
-    while (runnable) {
+RunStatus IntcodeComputer::run(uint64_t max_instructions) {
+    return execute(max_instructions, true);
+}
 
-        Value opcode = parse_opcode(memory.get(ip));
-        switch (opcode) {
-            case 1:
-                // addition
-                memory.set(get_write_address(3), get_read_param(1) + get_read_param(2));
+RunStatus IntcodeComputer::execute(uint64_t budget, bool stop_on_output) {
+#ifdef INTCODE_JIT
+    if (memory.jit)
+        return execute_compiled(budget, stop_on_output);
+#endif
+    return interpret(budget, stop_on_output);
+}
+
+RunStatus IntcodeComputer::interpret(uint64_t budget, bool stop_on_output) {
+    const Instruction *instruction;
+    RunStatus status;
+    // kept local so it can live in a register, added up on the way out, a handler throwing included
+    uint64_t q_dispatched{};
+    struct AddDispatched {
+        uint64_t &q_executed;
+        const uint64_t &q_dispatched;
+        ~AddDispatched() { q_executed += q_dispatched; }
+    } add_dispatched{q_executed, q_dispatched};
+
+#ifdef INTCODE_THREADED_DISPATCH
+    // indexed by Instruction::handler
+    static void *const dispatch_table[] = {
+        &&invalid, &&addition, &&multiplication, &&input_, &&output_, &&jump_if_true,
+        &&jump_if_false, &&less_than, &&equals, &&adjust_relative_base, &&halt,
+        &&addition_jump, &&less_than_jump, &&equals_jump
+    };
+
+    DISPATCH();
+#else
+    // main loop
+    while (true) {
+        if (q_dispatched >= budget) {
+            status = RunStatus::budget_exhausted;
+            goto suspend;
+        }
+        instruction = &memory.fetch(ip);
+        ++q_dispatched;
+        PROFILE(memory.profile.count(*instruction, ip));
+        switch (instruction->handler) {
+#endif
+
+            TARGET(1, addition)
+                memory.set(get_write_address(*instruction, 3), get_read_param(*instruction, 1) + get_read_param(*instruction, 2));
                 ip += 4;
-                break;
+                DISPATCH();
 
-            case 2:
-                // multiplication
-                memory.set(get_write_address(3), get_read_param(1) * get_read_param(2));
+            TARGET(2, multiplication)
+                memory.set(get_write_address(*instruction, 3), get_read_param(*instruction, 1) * get_read_param(*instruction, 2));
                 ip += 4;
-                break;
+                DISPATCH();
 
-            case 3:
-                // input
-                if (input.empty()) {
-                    // break out of the loop but keep the ip untouched so it can be resumed
-                    runnable = false;
+            TARGET(3, input_)
+                // values pushed earlier first, then the span
+                if (!input.empty()) {
+                    memory.set(get_write_address(*instruction, 1), input.front());
+                    input.pop();
                 }
+                else if (input_span != input_span_end) {
+                    memory.set(get_write_address(*instruction, 1), *input_span++);
+                }
+                // break out of the loop but keep the ip untouched so it can be resumed
                 else {
-                    memory.set(get_write_address(1), input.front());
-                    input.pop();
-                    ip += 2;
+                    --q_dispatched;
+                    PROFILE(memory.profile.stall(*instruction, ip));
+                    status = RunStatus::needs_input;
+                    goto suspend;
                 }
-                break;
+                ip += 2;
+                DISPATCH();
 
-            case 4:
-                // output
-                // assert(output.empty());
-                output.push(get_read_param(1));
-                // cout << "output: " << output.front() << endl;
+            TARGET(4, output_)
+                if (output_sink)
+                    (*output_sink)(get_read_param(*instruction, 1));
+                else
+                    output.push(get_read_param(*instruction, 1));
                 ip += 2;
-                break;
+                if (stop_on_output) {
+                    status = RunStatus::output_available;
+                    goto suspend;
+                }
+                DISPATCH();
 
-            case 5:
+            TARGET(5, jump_if_true)
                 // if first param is non-zero, second to ip
-                if (get_read_param(1))
-                    ip = static_cast<Address>(get_read_param(2));
+                if (get_read_param(*instruction, 1))
+                    ip = static_cast<Address>(get_read_param(*instruction, 2));
                 else
                     ip += 3;
-                break;
+                DISPATCH();
 
-            case 6:
+            TARGET(6, jump_if_false)
                 // if first param is zero, second to ip
-                if (!get_read_param(1))
-                    ip = static_cast<Address>(get_read_param(2));
+                if (!get_read_param(*instruction, 1))
+                    ip = static_cast<Address>(get_read_param(*instruction, 2));
                 else
                     ip += 3;
-                break;
+                DISPATCH();
 
-            case 7:
+            TARGET(7, less_than)
                 // if first less than second, 1 to third, otherwise 0
-                if (get_read_param(1) < get_read_param(2))
-                    memory.set(get_write_address(3), 1);
+                if (get_read_param(*instruction, 1) < get_read_param(*instruction, 2))
+                    memory.set(get_write_address(*instruction, 3), 1);
                 else
-                    memory.set(get_write_address(3), 0);
+                    memory.set(get_write_address(*instruction, 3), 0);
                 ip += 4;
-                break;
+                DISPATCH();
 
-            case 8:
+            TARGET(8, equals)
                 // if first equals second, 1 to third, otherwise 0
-                if (get_read_param(1) == get_read_param(2))
-                    memory.set(get_write_address(3), 1);
+                if (get_read_param(*instruction, 1) == get_read_param(*instruction, 2))
+                    memory.set(get_write_address(*instruction, 3), 1);
                 else
-                    memory.set(get_write_address(3), 0);
+                    memory.set(get_write_address(*instruction, 3), 0);
                 ip += 4;
-                break;
+                DISPATCH();
 
-            case 9:
+            TARGET(9, adjust_relative_base)
                 // add / substract from relative base
-                relative_base += get_read_param(1);
+                relative_base += get_read_param(*instruction, 1);
                 ip += 2;
-                break;
+                DISPATCH();
 
-            case 99:
+            TARGET(10, halt)
                 // graceful exit
-                runnable = false;
                 terminated = true;
-                break;
+                status = RunStatus::halted;
+                goto suspend;
+
+            // superinstructions, see Memory::fuse; a relative write may still land on the
+            // jump, in which case it is left to be decoded again on its own
+            TARGET(11, addition_jump)
+                {
+                    Address target = get_write_address(*instruction, 3);
+                    Value result = get_read_param(*instruction, 1) + get_read_param(*instruction, 2);
+                    memory.set(target, result);
+                    if (target >= ip + 4 && target <= ip + 6)
+                        ip += 4;
+                    else {
+                        fused_jump(*instruction, result);
+                        ++q_dispatched;
+                    }
+                }
+                DISPATCH();
+
+            TARGET(12, less_than_jump)
+                {
+                    Address target = get_write_address(*instruction, 3);
+                    Value result = get_read_param(*instruction, 1) < get_read_param(*instruction, 2);
+                    memory.set(target, result);
+                    if (target >= ip + 4 && target <= ip + 6)
+                        ip += 4;
+                    else {
+                        fused_jump(*instruction, result);
+                        ++q_dispatched;
+                    }
+                }
+                DISPATCH();
+
+            TARGET(13, equals_jump)
+                {
+                    Address target = get_write_address(*instruction, 3);
+                    Value result = get_read_param(*instruction, 1) == get_read_param(*instruction, 2);
+                    memory.set(target, result);
+                    if (target >= ip + 4 && target <= ip + 6)
+                        ip += 4;
+                    else {
+                        fused_jump(*instruction, result);
+                        ++q_dispatched;
+                    }
+                }
+                DISPATCH();
 
-            default:
+            TARGET_INVALID
                 terminated = true;
                 throw runtime_error("Invalid operation code");
+
+#ifndef INTCODE_THREADED_DISPATCH
         }
     }
+#endif
 
-    return output.front();
+suspend:
+    return status;
 }
 
+#undef TARGET
+#undef TARGET_INVALID
+#undef DISPATCH
+#undef PROFILE
+
+
+#ifdef INTCODE_PROFILE
+static const array<const char *, 14> HANDLER_NAMES{
+    "invalid", "add", "multiply", "input", "output", "jump_if_true",
+    "jump_if_false", "less_than", "equals", "adjust_relative_base", "halt",
+    "add_jump", "less_than_jump", "equals_jump"
+};
+
+void IntcodeProfile::count(const Instruction &instruction, Address ip) {
+    ++q_instructions;
+    ++q_by_handler[instruction.handler];
+    ++q_by_word[instruction.opcode + 100 * instruction.modes[0] + 1000 * instruction.modes[1] + 10000 * instruction.modes[2]];
+    ++q_by_address[ip];
+}
+
+// the input instruction was counted upon fetch but didn't run, it will be counted again on resume
+void IntcodeProfile::stall(const Instruction &instruction, Address ip) {
+    --q_instructions;
+    --q_by_handler[instruction.handler];
+    --q_by_word[instruction.opcode + 100 * instruction.modes[0] + 1000 * instruction.modes[1] + 10000 * instruction.modes[2]];
+    --q_by_address[ip];
+    ++q_input_stalls;
+}
+
+void IntcodeProfile::write_json(ostream &out) const {
+    out << "{\n";
+    out << "  \"instructions\": " << q_instructions << ",\n";
+
+    out << "  \"opcodes\": {";
+    for (size_t handler{}; handler<q_by_handler.size(); ++handler)
+        out << (handler ? ", " : "") << '"' << HANDLER_NAMES[handler] << "\": " << q_by_handler[handler];
+    out << "},\n";
+
+    map<int, uint64_t> by_word{q_by_word.begin(), q_by_word.end()};
+    out << "  \"instruction_words\": {";
+    for (auto it = by_word.begin(); it != by_word.end(); ++it)
+        out << (it != by_word.begin() ? ", " : "") << '"' << it->first << "\": " << it->second;
+    out << "},\n";
+
+    // hottest first
+    vector<pair<Address, uint64_t>> by_address{q_by_address.begin(), q_by_address.end()};
+    sort(by_address.begin(), by_address.end(), [](const auto &a, const auto &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    out << "  \"hot_addresses\": [";
+    for (size_t i{}; i<by_address.size() && i<20; ++i)
+        out << (i ? ", " : "") << "{\"ip\": " << by_address[i].first << ", \"count\": " << by_address[i].second << "}";
+    out << "],\n";
+
+    out << "  \"memory\": {";
+    out << "\"text_reads\": " << q_text_reads << ", \"text_writes\": " << q_text_writes << ", ";
+    out << "\"heap_reads\": " << q_heap_reads << ", \"heap_writes\": " << q_heap_writes << "},\n";
+
+    out << "  \"input_stalls\": " << q_input_stalls << "\n";
+    out << "}\n";
+}
+
+void IntcodeProfile::write_folded(ostream &out, int id, Address block_size) const {
+    map<Address, uint64_t> by_address{q_by_address.begin(), q_by_address.end()};
+    for (const auto &[ip, q]: by_address) {
+        Address block = ip / block_size * block_size;
+        out << "intcode_" << id << ";ip_" << block << '-' << block + block_size - 1 << ";ip_" << ip << ' ' << q << '\n';
+    }
+}
+
+const IntcodeProfile &IntcodeComputer::get_profile() {
+    return memory.profile;
+}
+
+void IntcodeComputer::write_profile_json(ostream &out) {
+    memory.profile.write_json(out);
+}
+
+void IntcodeComputer::write_profile_folded(ostream &out, Address block_size) {
+    memory.profile.write_folded(out, id, block_size);
+}
+#endif
@@ -0,0 +1,270 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "intcode_cfg.hpp"
+
+
+using namespace std;
+
+
+// constant addresses up to here are accessed directly in the flat memory, past it through
+// CompiledState like relative ones
+static const Value MAX_DIRECT_ADDRESS{1 << 20};
+
+
+class Generator {
+
+    public:
+
+    Generator(const ControlFlowGraph &graph) : text(graph.get_text()), reachable(graph.get_instructions()) {
+        code.assign(text.size(), false);
+        live.assign(text.size(), false);
+        memory_size = text.size();
+        for (const auto &[address, disassembled]: reachable) {
+            if (!disassembled.valid)
+                continue;
+            for (Address word{address}; word<disassembled.next(); ++word)
+                code[word] = true;
+        }
+
+        // parameters the program itself rewrites through a constant address, jump tables and
+        // the like, are read from memory each time instead of being compiled in
+        for (const auto &write: graph.get_self_modifying_writes()) {
+            if (write.word != write.instruction) {
+                live[write.word] = true;
+                code[write.word] = false;
+            }
+        }
+
+        for (const auto &[address, disassembled]: reachable) {
+            if (!disassembled.valid)
+                continue;
+            const Instruction &instruction = disassembled.instruction;
+            for (int i{}; i<instruction.q_params; ++i) {
+                Value param = instruction.params[i];
+                if (!instruction.modes[i] && !live[address + 1 + i] && param >= 0 && param < MAX_DIRECT_ADDRESS)
+                    memory_size = max(memory_size, static_cast<size_t>(param) + 1);
+            }
+            if (disassembled.is_jump() && !is_constant(address, instruction, 1))
+                computed_jumps = true;
+        }
+    }
+
+    void write(ostream &out, const string &source, const string &symbol) const {
+        out << "// translated from " << source << " by intcode_aot, do not edit\n"
+            << "#include \"intcode_compiled.hpp\"\n\n\n";
+
+        write_array(out, "static const Value TEXT[]", text);
+        write_array(out, "static const bool CODE[]", code);
+
+        out << "#define EXIT(at, why) do { s.ip = (at); s.relative_base = rb; return CompiledExit::why; } while (0)\n"
+            << "#define READ(address) (static_cast<uint64_t>(address) < size ? m[address] : s.read(address))\n"
+            << "// writing to a translated instruction leaves the rest of the run to the interpreter\n"
+            << "#define WRITE(address, value, next) do { \\\n"
+            << "        Address w_ = (address); Value v_ = (value); \\\n"
+            << "        if (static_cast<uint64_t>(w_) < size && (static_cast<uint64_t>(w_) >= " << text.size() << " || !CODE[w_])) \\\n"
+            << "            m[w_] = v_; \\\n"
+            << "        else { \\\n"
+            << "            s.write(w_, v_); \\\n"
+            << "            m = s.memory.data(); \\\n"
+            << "            size = s.memory.size(); \\\n"
+            << "            if (s.code_modified) EXIT(next, escape); \\\n"
+            << "        } \\\n"
+            << "    } while (0)\n\n";
+
+        out << "static CompiledExit run(CompiledState &s) {\n"
+            << "    Value *m = s.memory.data();\n"
+            << "    [[maybe_unused]] uint64_t size = s.memory.size();\n"
+            << "    Address rb = s.relative_base;\n"
+            << "    [[maybe_unused]] Address target;\n"
+            << "    [[maybe_unused]] Value input;\n\n";
+        if (computed_jumps)
+            out << "dispatch:\n";
+        out << "    switch (s.ip) {\n";
+        for (const auto &entry: reachable)
+            out << "        case " << entry.first << ": goto L" << entry.first << ";\n";
+        out << "    }\n"
+            << "    EXIT(s.ip, escape);\n\n";
+
+        for (const auto &entry: reachable)
+            write_instruction(out, entry.second);
+
+        out << "}\n\n"
+            << "#undef EXIT\n#undef READ\n#undef WRITE\n\n"
+            << "extern const CompiledProgram " << symbol << "{TEXT, " << text.size() << ", CODE, "
+            << memory_size << ", run};\n";
+    }
+
+    private:
+
+    template <typename T>
+    void write_array(ostream &out, const string &declaration, const vector<T> &values) const {
+        out << declaration << "{";
+        for (size_t i{}; i<values.size(); ++i)
+            out << (i % 16 ? " " : "\n    ") << values[i] << ",";
+        out << "\n};\n\n";
+    }
+
+    bool is_constant(Address address, const Instruction &instruction, int i) const {
+        return instruction.modes[i] == 1 && !live[address + 1 + i];
+    }
+
+    // the parameter word itself, compiled in unless the program rewrites it
+    string param_word(Address address, const Instruction &instruction, int i) const {
+        if (live[address + 1 + i])
+            return "m[" + to_string(address + 1 + i) + "]";
+        return to_string(instruction.params[i]);
+    }
+
+    string read_param(Address address, const Instruction &instruction, int i) const {
+        Value param = instruction.params[i];
+        bool is_live = live[address + 1 + i];
+        switch (instruction.modes[i]) {
+            case 0:
+                if (!is_live && param >= 0 && param < static_cast<Value>(memory_size))
+                    return "m[" + to_string(param) + "]";
+                return "READ(" + param_word(address, instruction, i) + ")";
+            case 1:
+                return is_live ? param_word(address, instruction, i) : "Value{" + to_string(param) + "}";
+            default:
+                return "READ(rb + " + param_word(address, instruction, i) + ")";
+        }
+    }
+
+    // true when it ends the compiled run
+    bool write_param(ostream &out, Address address, const Instruction &instruction, int i, const string &value, Address next) const {
+        Value param = instruction.params[i];
+        if (!instruction.modes[i] && !live[address + 1 + i] && param >= 0 && param < static_cast<Value>(memory_size)) {
+            out << "    m[" << param << "] = " << value << ";\n";
+            if (param >= static_cast<Value>(code.size()) || !code[param])
+                return false;
+            out << "    s.code_modified = true;\n"
+                << "    EXIT(" << next << ", escape);\n";
+            return true;
+        }
+
+        string word = param_word(address, instruction, i);
+        out << "    WRITE(" << (instruction.modes[i] ? "rb + " + word : word) << ", " << value << ", " << next << ");\n";
+        return false;
+    }
+
+    void write_jump(ostream &out, Address address, const Instruction &instruction) const {
+        if (is_constant(address, instruction, 1)) {
+            Address target = instruction.params[1];
+            if (reachable.count(target))
+                out << "goto L" << target << ";\n";
+            else
+                out << "EXIT(" << target << ", escape);\n";
+            return;
+        }
+        out << "{ target = " << read_param(address, instruction, 1) << "; s.ip = target; goto dispatch; }\n";
+    }
+
+    void write_instruction(ostream &out, const ProgramInstruction &disassembled) const {
+        Address address = disassembled.address;
+        const Instruction &instruction = disassembled.instruction;
+        out << "L" << address << ":  //";
+        for (Address a{address}; a<=address + instruction.q_params && a < static_cast<Address>(text.size()); ++a)
+            out << " " << text[a];
+        out << "\n";
+
+        if (!disassembled.valid) {
+            out << "    EXIT(" << address << ", escape);\n\n";
+            return;
+        }
+
+        auto read = [&](int i) { return read_param(address, instruction, i); };
+        Address next = disassembled.next();
+        bool exits{false};
+        switch (instruction.opcode) {
+            case 1:
+                exits = write_param(out, address, instruction, 2, read(0) + " + " + read(1), next);
+                break;
+
+            case 2:
+                exits = write_param(out, address, instruction, 2, read(0) + " * " + read(1), next);
+                break;
+
+            case 3:
+                out << "    if (s.input.empty())\n"
+                    << "        EXIT(" << address << ", needs_input);\n"
+                    << "    input = s.input.front();\n"
+                    << "    s.input.pop();\n";
+                exits = write_param(out, address, instruction, 0, "input", next);
+                break;
+
+            case 4:
+                out << "    s.output.push(" << read(0) << ");\n";
+                break;
+
+            case 5: case 6:
+                if (is_constant(address, instruction, 0)) {
+                    if (disassembled.always_jumps()) {
+                        out << "    ";
+                        write_jump(out, address, instruction);
+                        out << "\n";
+                        return;
+                    }
+                    break;
+                }
+                out << "    if (" << read(0) << (instruction.opcode == 5 ? " != 0" : " == 0") << ")\n        ";
+                write_jump(out, address, instruction);
+                break;
+
+            case 7:
+                exits = write_param(out, address, instruction, 2, "Value{" + read(0) + " < " + read(1) + "}", next);
+                break;
+
+            case 8:
+                exits = write_param(out, address, instruction, 2, "Value{" + read(0) + " == " + read(1) + "}", next);
+                break;
+
+            case 9:
+                out << "    rb += " << read(0) << ";\n";
+                break;
+
+            case 99:
+                out << "    s.terminated = true;\n"
+                    << "    EXIT(" << address << ", halted);\n\n";
+                return;
+        }
+
+        if (exits)
+            out << "\n";
+        else if (reachable.count(next))
+            out << "    goto L" << next << ";\n\n";
+        else
+            out << "    EXIT(" << next << ", escape);\n\n";
+    }
+
+    const Text &text;
+    const map<Address, ProgramInstruction> &reachable;
+    // words of translated instructions compiled in, and parameter words read at run time instead
+    vector<bool> code;
+    vector<bool> live;
+    size_t memory_size;
+    bool computed_jumps{false};
+};
+
+
+// translates an Intcode program, text or binary, into a C++ translation unit exporting a
+// CompiledProgram for CompiledIntcodeComputer
+int main(int argc, char **argv) {
+    if (argc < 3 || argc > 4) {
+        cerr << "usage: " << argv[0] << " program output.cpp [symbol]" << endl;
+        return 1;
+    }
+
+    ControlFlowGraph graph{is_binary_program(argv[1]) ? read_binary_program(argv[1]) : read_text_program(argv[1])};
+
+    ofstream out{argv[2]};
+    Generator{graph}.write(out, argv[1], argc == 4 ? argv[3] : "compiled_program");
+    if (!out)
+        throw runtime_error("Can't write the translation");
+    cout << "Translated " << graph.get_instructions().size() << " instructions of " << graph.get_text().size()
+         << " words into " << argv[2] << endl;
+
+    return 0;
+}
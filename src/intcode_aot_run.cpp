@@ -0,0 +1,29 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "intcode_compiled.hpp"
+
+
+using namespace std;
+
+
+// whichever program intcode_aot translated and got linked in
+extern const CompiledProgram compiled_program;
+
+
+// runs a compiled program on the inputs given as arguments, printing its outputs
+int main(int argc, char **argv) {
+    CompiledIntcodeComputer computer{0, compiled_program};
+    for (int i{1}; i<argc; ++i)
+        computer.push_input(strtoll(argv[i], nullptr, 10));
+
+    computer.run();
+    while (computer.output_size())
+        cout << computer.pop_output() << endl;
+    if (!computer.has_terminated()) {
+        cerr << "Waiting for more input" << endl;
+        return 1;
+    }
+
+    return 0;
+}
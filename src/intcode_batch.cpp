@@ -0,0 +1,222 @@
+#include <cassert>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include "intcode_batch.hpp"
+
+
+using namespace std;
+
+// don't let a runaway address eat all the memory, it is multiplied by the amount of lanes
+constexpr Address MAX_BATCH_ADDRESSES = Address{1} << 20;
+
+
+IntcodeBatch::IntcodeBatch(const Text &text, size_t q_lanes) :
+    words(text.size() * q_lanes),
+    q_lanes(q_lanes),
+    q_addresses(text.size()),
+    ip(q_lanes),
+    relative_base(q_lanes),
+    state(q_lanes, LaneState::running),
+    input(q_lanes),
+    output(q_lanes)
+{
+    for (size_t address{}; address<text.size(); ++address)
+        for (size_t lane{}; lane<q_lanes; ++lane)
+            words[address * q_lanes + lane] = text[address];
+}
+
+size_t IntcodeBatch::size() const {
+    return q_lanes;
+}
+
+void IntcodeBatch::grow(Address address) {
+    if (address >= MAX_BATCH_ADDRESSES)
+        throw runtime_error("Batch memory address out of range");
+
+    // rows are appended at the end, so existing words keep their place
+    q_addresses = max(address + 1, min(2 * q_addresses, MAX_BATCH_ADDRESSES));
+    words.resize(q_addresses * q_lanes);
+}
+
+inline Value &IntcodeBatch::word(Address address, size_t lane) {
+    assert(address >= 0);
+    if (address >= q_addresses)
+        grow(address);
+    return words[address * q_lanes + lane];
+}
+
+// evaluate the value before taking the reference, growing the memory invalidates it
+inline void IntcodeBatch::write(size_t lane, Address address, Value value) {
+    word(address, lane) = value;
+}
+
+void IntcodeBatch::set(size_t lane, Address address, Value value) {
+    write(lane, address, value);
+}
+
+Value IntcodeBatch::get(size_t lane, Address address) const {
+    assert(address >= 0);
+    return address < q_addresses ? words[address * q_lanes + lane] : 0;
+}
+
+void IntcodeBatch::push_input(size_t lane, Value value) {
+    input[lane].push(value);
+    if (state[lane] == LaneState::waiting_input)
+        state[lane] = LaneState::running;
+}
+
+Value IntcodeBatch::pop_output(size_t lane) {
+    Value aux = output[lane].front();
+    output[lane].pop();
+    return aux;
+}
+
+size_t IntcodeBatch::output_size(size_t lane) const {
+    return output[lane].size();
+}
+
+bool IntcodeBatch::has_terminated(size_t lane) const {
+    return state[lane] == LaneState::terminated;
+}
+
+Value IntcodeBatch::get_read_param(const Instruction &instruction, size_t lane, int offset) {
+    Value param = word(ip[lane] + offset, lane);
+
+    switch (instruction.modes[offset - 1]) {
+        case 0: return word(param, lane);
+        case 1: return param;
+        case 2: return word(param + relative_base[lane], lane);
+    }
+
+    throw runtime_error("Invalid parameter mode");
+}
+
+Address IntcodeBatch::get_write_address(const Instruction &instruction, size_t lane, int offset) {
+    Value param = word(ip[lane] + offset, lane);
+
+    switch (instruction.modes[offset - 1]) {
+        case 0: return param;
+        case 2: return param + relative_base[lane];
+    }
+
+    throw runtime_error("Invalid write address mode");
+}
+
+void IntcodeBatch::step(const vector<size_t> &group) {
+    // every lane in the group is at the same ip with the same instruction word
+    const Instruction instruction = Instruction::decode(word(ip[group.front()], group.front()));
+
+    switch (instruction.opcode) {
+        case 1:
+            for (auto lane: group) {
+                write(lane, get_write_address(instruction, lane, 3), get_read_param(instruction, lane, 1) + get_read_param(instruction, lane, 2));
+                ip[lane] += 4;
+            }
+            break;
+
+        case 2:
+            for (auto lane: group) {
+                write(lane, get_write_address(instruction, lane, 3), get_read_param(instruction, lane, 1) * get_read_param(instruction, lane, 2));
+                ip[lane] += 4;
+            }
+            break;
+
+        case 3:
+            for (auto lane: group) {
+                // keep the ip so the lane resumes here once it gets input
+                if (input[lane].empty()) {
+                    state[lane] = LaneState::waiting_input;
+                    continue;
+                }
+                write(lane, get_write_address(instruction, lane, 1), input[lane].front());
+                input[lane].pop();
+                ip[lane] += 2;
+            }
+            break;
+
+        case 4:
+            for (auto lane: group) {
+                output[lane].push(get_read_param(instruction, lane, 1));
+                ip[lane] += 2;
+            }
+            break;
+
+        case 5:
+            for (auto lane: group)
+                ip[lane] = get_read_param(instruction, lane, 1) ? get_read_param(instruction, lane, 2) : ip[lane] + 3;
+            break;
+
+        case 6:
+            for (auto lane: group)
+                ip[lane] = !get_read_param(instruction, lane, 1) ? get_read_param(instruction, lane, 2) : ip[lane] + 3;
+            break;
+
+        case 7:
+            for (auto lane: group) {
+                write(lane, get_write_address(instruction, lane, 3), get_read_param(instruction, lane, 1) < get_read_param(instruction, lane, 2));
+                ip[lane] += 4;
+            }
+            break;
+
+        case 8:
+            for (auto lane: group) {
+                write(lane, get_write_address(instruction, lane, 3), get_read_param(instruction, lane, 1) == get_read_param(instruction, lane, 2));
+                ip[lane] += 4;
+            }
+            break;
+
+        case 9:
+            for (auto lane: group) {
+                relative_base[lane] += get_read_param(instruction, lane, 1);
+                ip[lane] += 2;
+            }
+            break;
+
+        case 99:
+            for (auto lane: group)
+                state[lane] = LaneState::terminated;
+            break;
+
+        default:
+            for (auto lane: group)
+                state[lane] = LaneState::terminated;
+            throw runtime_error("Invalid operation code");
+    }
+}
+
+void IntcodeBatch::run() {
+    vector<size_t> group;
+    group.reserve(q_lanes);
+
+    while (true) {
+        // the lanes furthest behind go first, which lets diverged lanes meet again
+        Address min_ip{numeric_limits<Address>::max()};
+        for (size_t lane{}; lane<q_lanes; ++lane)
+            if (state[lane] == LaneState::running && ip[lane] < min_ip)
+                min_ip = ip[lane];
+
+        // everybody halted or waiting for input
+        if (min_ip == numeric_limits<Address>::max())
+            break;
+
+        group.clear();
+        Value instruction_word{};
+        for (size_t lane{}; lane<q_lanes; ++lane) {
+            if (state[lane] != LaneState::running || ip[lane] != min_ip)
+                continue;
+
+            // a lane that rewrote this instruction takes its own turn later
+            if (group.empty())
+                instruction_word = word(min_ip, lane);
+            else if (word(min_ip, lane) != instruction_word)
+                continue;
+
+            group.push_back(lane);
+        }
+
+        step(group);
+    }
+}
@@ -0,0 +1,90 @@
+#include <stdexcept>
+
+#include "intcode_cache.hpp"
+
+
+using namespace std;
+
+
+// FNV-1a over the bytes of each word
+static uint64_t hash_words(uint64_t hash, const vector<Value> &words) {
+    for (auto word: words)
+        for (size_t byte{}; byte<sizeof(Value); ++byte) {
+            hash ^= (static_cast<uint64_t>(word) >> (8 * byte)) & 0xff;
+            hash *= 0x100000001b3;
+        }
+    return hash;
+}
+
+static const uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+
+
+bool IntcodeRunCache::Key::operator==(const Key &other) const {
+    return program == other.program && inputs == other.inputs;
+}
+
+size_t IntcodeRunCache::KeyHash::operator()(const Key &key) const {
+    return hash_words(key.program, key.inputs);
+}
+
+
+IntcodeRunCache::IntcodeRunCache(size_t capacity) : capacity(capacity) {
+    if (!capacity)
+        throw invalid_argument("Run cache needs room for at least one run");
+}
+
+uint64_t IntcodeRunCache::add(const Text &text) {
+    uint64_t program = hash_words(FNV_OFFSET_BASIS, text);
+    for (auto found = programs.find(program); found != programs.end(); found = programs.find(++program))
+        if (found->second.text == text)
+            return program;
+
+    programs.emplace(program, Program{text, IntcodeComputer::partially_evaluated(0, text)});
+    return program;
+}
+
+vector<Value> IntcodeRunCache::run(uint64_t program, const vector<Value> &inputs) {
+    Key key{program, inputs};
+    auto found = index.find(key);
+    if (found != index.end()) {
+        ++q_hits;
+        entries.splice(entries.begin(), entries, found->second);
+        return found->second->outputs;
+    }
+    ++q_misses;
+
+    auto start = programs.find(program);
+    if (start == programs.end())
+        throw invalid_argument("Unknown program, add it to the run cache first");
+
+    auto computer = start->second.start.fork();
+    for (auto value: inputs)
+        computer.push_input(value);
+    computer.run();
+    if (!computer.has_terminated())
+        throw runtime_error("Program waits for more input than given, its outputs can't be cached");
+
+    vector<Value> outputs;
+    while (computer.output_size())
+        outputs.push_back(computer.pop_output());
+
+    if (entries.size() == capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front(Entry{move(key), move(outputs)});
+    index.emplace(entries.front().key, entries.begin());
+    return entries.front().outputs;
+}
+
+size_t IntcodeRunCache::size() const {
+    return entries.size();
+}
+
+size_t IntcodeRunCache::hits() const {
+    return q_hits;
+}
+
+size_t IntcodeRunCache::misses() const {
+    return q_misses;
+}
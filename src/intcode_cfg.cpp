@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include "intcode_cfg.hpp"
+
+
+using namespace std;
+
+
+Address ProgramInstruction::next() const {
+    return address + 1 + instruction.q_params;
+}
+
+bool ProgramInstruction::is_jump() const {
+    return instruction.opcode == 5 || instruction.opcode == 6;
+}
+
+bool ProgramInstruction::always_jumps() const {
+    return is_jump() && instruction.modes[0] == 1 && (instruction.opcode == 5) == (instruction.params[0] != 0);
+}
+
+bool ProgramInstruction::never_jumps() const {
+    return is_jump() && instruction.modes[0] == 1 && (instruction.opcode == 5) == (instruction.params[0] == 0);
+}
+
+bool ProgramInstruction::has_constant_target() const {
+    return is_jump() && instruction.modes[1] == 1;
+}
+
+bool ProgramInstruction::writes() const {
+    switch (instruction.opcode) {
+        case 1: case 2: case 3: case 7: case 8:
+            return true;
+    }
+    return false;
+}
+
+
+static ProgramInstruction disassemble(const Text &text, Address address) {
+    ProgramInstruction disassembled{address, Instruction::decode(text[address]), false};
+    Instruction &instruction = disassembled.instruction;
+    if (instruction.opcode == 99) {
+        disassembled.valid = true;
+        return disassembled;
+    }
+    if (!instruction.handler || address + instruction.q_params >= static_cast<Address>(text.size()))
+        return disassembled;
+
+    for (int i{}; i<instruction.q_params; ++i) {
+        instruction.params[i] = text[address + 1 + i];
+        if (instruction.modes[i] > 2)
+            return disassembled;
+    }
+    disassembled.valid = !disassembled.writes() || instruction.modes[instruction.q_params - 1] != 1;
+    return disassembled;
+}
+
+
+ControlFlowGraph::ControlFlowGraph(const Text &text) : text(text) {
+    find_instructions();
+    find_blocks();
+    find_self_modifying_writes();
+}
+
+const Text &ControlFlowGraph::get_text() const {
+    return text;
+}
+
+const map<Address, ProgramInstruction> &ControlFlowGraph::get_instructions() const {
+    return instructions;
+}
+
+const map<Address, BasicBlock> &ControlFlowGraph::get_blocks() const {
+    return blocks;
+}
+
+const vector<SelfModifyingWrite> &ControlFlowGraph::get_self_modifying_writes() const {
+    return self_modifying_writes;
+}
+
+const vector<Call> &ControlFlowGraph::get_calls() const {
+    return calls;
+}
+
+const vector<Address> &ControlFlowGraph::get_returns() const {
+    return returns;
+}
+
+const ProgramInstruction *ControlFlowGraph::instruction_at(Address address) const {
+    auto it = instructions.find(address);
+    return it == instructions.end() ? nullptr : &it->second;
+}
+
+// from address 0 following fall through and constant jump targets. returns are computed jumps,
+// so the address after an unconditional jump is also followed when some instruction stores it
+// as a constant, the usual way of pushing a return address
+void ControlFlowGraph::find_instructions() {
+    vector<Address> pending{0};
+    // unconditional jumps by the address after them, and the constants stored by adding 0
+    map<Address, Address> after_jumps;
+    set<Value> stored_constants;
+
+    while (!pending.empty()) {
+        while (!pending.empty()) {
+            Address address = pending.back();
+            pending.pop_back();
+            if (address < 0 || address >= static_cast<Address>(text.size()) || instructions.count(address))
+                continue;
+
+            const ProgramInstruction &disassembled = instructions[address] = disassemble(text, address);
+            const Instruction &instruction = disassembled.instruction;
+            if (!disassembled.valid || instruction.opcode == 99)
+                continue;
+
+            if (disassembled.is_jump()) {
+                if (disassembled.has_constant_target() && !disassembled.never_jumps())
+                    pending.push_back(instruction.params[1]);
+                if (instruction.modes[1] == 2 && !disassembled.never_jumps())
+                    returns.push_back(address);
+                if (disassembled.always_jumps()) {
+                    after_jumps[disassembled.next()] = address;
+                    continue;
+                }
+            }
+            if (instruction.opcode == 1 && instruction.modes[0] == 1 && instruction.modes[1] == 1) {
+                if (!instruction.params[0])
+                    stored_constants.insert(instruction.params[1]);
+                if (!instruction.params[1])
+                    stored_constants.insert(instruction.params[0]);
+            }
+            pending.push_back(disassembled.next());
+        }
+
+        for (const auto &after_jump: after_jumps) {
+            if (stored_constants.count(after_jump.first) && !instructions.count(after_jump.first))
+                pending.push_back(after_jump.first);
+        }
+    }
+
+    for (const auto &[return_address, site]: after_jumps) {
+        if (stored_constants.count(return_address)) {
+            const Instruction &jump = instructions[site].instruction;
+            calls.push_back({site, jump.modes[1] == 1 ? jump.params[1] : -1, return_address});
+        }
+    }
+    sort(returns.begin(), returns.end());
+    sort(calls.begin(), calls.end(), [](const Call &a, const Call &b) { return a.site < b.site; });
+}
+
+void ControlFlowGraph::find_blocks() {
+    // leaders: the entry, jump targets, what follows a jump and return addresses
+    set<Address> leaders{0};
+    for (const auto &[address, disassembled]: instructions) {
+        if (disassembled.is_jump() && disassembled.valid) {
+            if (disassembled.has_constant_target())
+                leaders.insert(disassembled.instruction.params[1]);
+            leaders.insert(disassembled.next());
+        }
+    }
+    for (const Call &call: calls)
+        leaders.insert(call.return_address);
+
+    BasicBlock *block{nullptr};
+    for (const auto &[address, disassembled]: instructions) {
+        if (!block || leaders.count(address) || block->end != address) {
+            // falling into it
+            if (block && block->end == address)
+                block->successors.push_back(address);
+            block = &blocks[address];
+            *block = BasicBlock{address, address, {}, {}, false, false};
+        }
+
+        block->instructions.push_back(address);
+        block->end = disassembled.valid ? disassembled.next() : address + 1;
+
+        // invalid instructions end it as well, the interpreter stops there
+        const Instruction &instruction = disassembled.instruction;
+        if (disassembled.valid && instruction.opcode == 99)
+            block->halts = true;
+        if (disassembled.valid && disassembled.is_jump()) {
+            if (!disassembled.never_jumps()) {
+                if (!disassembled.has_constant_target())
+                    block->computed_exit = true;
+                else if (instructions.count(instruction.params[1]))
+                    block->successors.push_back(instruction.params[1]);
+            }
+            if (!disassembled.always_jumps() && instructions.count(disassembled.next()))
+                block->successors.push_back(disassembled.next());
+        }
+        if (!disassembled.valid || instruction.opcode == 99 || disassembled.is_jump())
+            block = nullptr;
+    }
+}
+
+void ControlFlowGraph::find_self_modifying_writes() {
+    // every word of a reachable instruction, to the instruction
+    map<Address, Address> words;
+    for (const auto &[address, disassembled]: instructions) {
+        if (!disassembled.valid)
+            continue;
+        for (Address word{address}; word<disassembled.next(); ++word)
+            words[word] = address;
+    }
+
+    for (const auto &[address, disassembled]: instructions) {
+        const Instruction &instruction = disassembled.instruction;
+        if (!disassembled.valid || !disassembled.writes() || instruction.modes[instruction.q_params - 1])
+            continue;
+
+        auto written = words.find(instruction.params[instruction.q_params - 1]);
+        if (written != words.end())
+            self_modifying_writes.push_back({address, written->first, written->second});
+    }
+}
+
+
+static const char *mnemonic(int opcode) {
+    switch (opcode) {
+        case 1: return "add";
+        case 2: return "mul";
+        case 3: return "in";
+        case 4: return "out";
+        case 5: return "jnz";
+        case 6: return "jz";
+        case 7: return "lt";
+        case 8: return "eq";
+        case 9: return "arb";
+        case 99: return "halt";
+    }
+    return "?";
+}
+
+static string operand(const Instruction &instruction, int i) {
+    string param = to_string(instruction.params[i]);
+    switch (instruction.modes[i]) {
+        case 0: return "[" + param + "]";
+        case 1: return param;
+        default: return "[rb" + string(instruction.params[i] < 0 ? "" : "+") + param + "]";
+    }
+}
+
+void ControlFlowGraph::write(ostream &out) const {
+    map<Address, const SelfModifyingWrite *> writes_by_writer;
+    for (const auto &write: self_modifying_writes)
+        writes_by_writer[write.writer] = &write;
+    map<Address, const Call *> calls_by_site;
+    for (const auto &call: calls)
+        calls_by_site[call.site] = &call;
+    set<Address> return_sites(returns.begin(), returns.end());
+
+    for (const auto &[begin, block]: blocks) {
+        out << "block " << begin << ".." << block.end - 1;
+        if (!block.successors.empty()) {
+            out << " ->";
+            for (Address successor: block.successors)
+                out << " " << successor;
+        }
+        if (block.computed_exit)
+            out << " -> ?";
+        if (block.halts)
+            out << " halts";
+        out << "\n";
+
+        for (Address address: block.instructions) {
+            const ProgramInstruction &disassembled = instructions.at(address);
+            const Instruction &instruction = disassembled.instruction;
+
+            ostringstream words;
+            for (Address word{address}; word<block.end && (word == address || word < disassembled.next()); ++word)
+                words << text[word] << " ";
+
+            ostringstream code;
+            if (!disassembled.valid) {
+                code << "invalid";
+            }
+            else {
+                code << mnemonic(instruction.opcode);
+                for (int i{}; i<instruction.q_params; ++i)
+                    code << (i ? ", " : " ") << operand(instruction, i);
+            }
+
+            ostringstream annotation;
+            if (writes_by_writer.count(address))
+                annotation << "; rewrites word " << writes_by_writer[address]->word << " of " << writes_by_writer[address]->instruction;
+            else if (calls_by_site.count(address))
+                annotation << "; call " << calls_by_site[address]->target << ", back at " << calls_by_site[address]->return_address;
+            else if (return_sites.count(address))
+                annotation << "; return";
+
+            out << setw(8) << address << "  " << left << setw(24) << words.str();
+            if (annotation.str().empty())
+                out << code.str();
+            else
+                out << setw(32) << code.str() << annotation.str();
+            out << right << "\n";
+        }
+    }
+}
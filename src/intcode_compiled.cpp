@@ -0,0 +1,160 @@
+#include <stdexcept>
+
+#include "intcode_compiled.hpp"
+
+
+using namespace std;
+
+
+// the flat memory grows up to here, further addresses go to a sparse map
+static const Address MAX_COMPILED_FLAT_ADDRESS = Address{1} << 24;
+
+
+Value CompiledState::read(Address address) {
+    if (address < 0)
+        throw runtime_error("Negative address");
+    if (static_cast<size_t>(address) < memory.size())
+        return memory[address];
+
+    auto it = far_heap.find(address);
+    return it == far_heap.end() ? 0 : it->second;
+}
+
+void CompiledState::write(Address address, Value value) {
+    if (address < 0)
+        throw runtime_error("Negative address");
+    if (static_cast<size_t>(address) < program->text_size && program->code[address])
+        code_modified = true;
+
+    if (address < MAX_COMPILED_FLAT_ADDRESS) {
+        if (static_cast<size_t>(address) >= memory.size())
+            memory.resize(max(static_cast<size_t>(address) + 1, 2 * memory.size()));
+        memory[address] = value;
+    }
+    else {
+        far_heap[address] = value;
+    }
+}
+
+
+CompiledIntcodeComputer::CompiledIntcodeComputer(int id, const CompiledProgram &program) : id(id) {
+    state.program = &program;
+    state.memory.assign(program.text, program.text + program.text_size);
+    state.memory.resize(max(program.memory_size, program.text_size));
+}
+
+void CompiledIntcodeComputer::push_input(Value value) {
+    state.input.push(value);
+}
+
+Value CompiledIntcodeComputer::pop_output() {
+    Value aux = state.output.front();
+    state.output.pop();
+    return aux;
+}
+
+size_t CompiledIntcodeComputer::output_size() {
+    return state.output.size();
+}
+
+bool CompiledIntcodeComputer::has_terminated() {
+    return state.terminated;
+}
+
+Value CompiledIntcodeComputer::run() {
+    while (true) {
+        // native code from wherever it can take over, unless the program rewrote itself
+        if (!state.code_modified) {
+            CompiledExit exit = state.program->run(state);
+            if (exit != CompiledExit::escape)
+                break;
+        }
+
+        // escape hatch, one instruction at a time until an entry point comes up again
+        if (!step())
+            break;
+    }
+
+    // waiting on input before having output anything
+    if (state.output.empty())
+        return 0;
+    return state.output.front();
+}
+
+Value CompiledIntcodeComputer::get_read_param(const Instruction &instruction, int offset) {
+    Value param = state.read(state.ip + offset);
+    switch (instruction.modes[offset - 1]) {
+        case 0: return state.read(param);
+        case 1: return param;
+        case 2: return state.read(param + state.relative_base);
+    }
+    throw runtime_error("Invalid parameter mode");
+}
+
+Address CompiledIntcodeComputer::get_write_address(const Instruction &instruction, int offset) {
+    Value param = state.read(state.ip + offset);
+    switch (instruction.modes[offset - 1]) {
+        case 0: return param;
+        case 2: return param + state.relative_base;
+    }
+    throw runtime_error("Invalid parameter mode for writing");
+}
+
+// false when it halts or waits for input
+bool CompiledIntcodeComputer::step() {
+    Instruction instruction = Instruction::decode(state.read(state.ip));
+    switch (instruction.opcode) {
+        case 1:
+            state.write(get_write_address(instruction, 3), get_read_param(instruction, 1) + get_read_param(instruction, 2));
+            state.ip += 4;
+            return true;
+
+        case 2:
+            state.write(get_write_address(instruction, 3), get_read_param(instruction, 1) * get_read_param(instruction, 2));
+            state.ip += 4;
+            return true;
+
+        case 3:
+            if (state.input.empty())
+                return false;
+            state.write(get_write_address(instruction, 1), state.input.front());
+            state.input.pop();
+            state.ip += 2;
+            return true;
+
+        case 4:
+            state.output.push(get_read_param(instruction, 1));
+            state.ip += 2;
+            return true;
+
+        case 5: case 6:
+            if ((instruction.opcode == 5) == (get_read_param(instruction, 1) != 0))
+                state.ip = get_read_param(instruction, 2);
+            else
+                state.ip += 3;
+            return true;
+
+        case 7:
+            state.write(get_write_address(instruction, 3), get_read_param(instruction, 1) < get_read_param(instruction, 2));
+            state.ip += 4;
+            return true;
+
+        case 8:
+            state.write(get_write_address(instruction, 3), get_read_param(instruction, 1) == get_read_param(instruction, 2));
+            state.ip += 4;
+            return true;
+
+        case 9:
+            state.relative_base += get_read_param(instruction, 1);
+            state.ip += 2;
+            return true;
+
+        case 99:
+            state.terminated = true;
+            return false;
+
+        default:
+            state.terminated = true;
+            throw runtime_error("Invalid operation code");
+    }
+}
@@ -0,0 +1,24 @@
+#include <iostream>
+
+#include "intcode_cfg.hpp"
+
+
+using namespace std;
+
+
+// lists an Intcode program, text or binary, by basic block
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        cerr << "usage: " << argv[0] << " program" << endl;
+        return 1;
+    }
+
+    ControlFlowGraph graph{is_binary_program(argv[1]) ? read_binary_program(argv[1]) : read_text_program(argv[1])};
+    graph.write(cout);
+    cout << "\n" << graph.get_instructions().size() << " instructions in " << graph.get_blocks().size()
+         << " blocks out of " << graph.get_text().size() << " words, "
+         << graph.get_calls().size() << " calls, " << graph.get_returns().size() << " returns, "
+         << graph.get_self_modifying_writes().size() << " self-modifying writes" << endl;
+
+    return 0;
+}
@@ -0,0 +1,1001 @@
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "intcode.hpp"
+#include "intcode_jit.hpp"
+
+
+using namespace std;
+
+
+#ifdef INTCODE_JIT
+
+// why compiled code went back to the dispatch loop, helpers return 0 to carry on
+enum JitExit : int { EXIT_CONTINUE = 1, EXIT_NEEDS_INPUT, EXIT_HALTED, EXIT_OUTPUT, EXIT_ERROR };
+
+// blocks compiled together in one go at most
+static const size_t MAX_REGION_BLOCKS = 256;
+
+
+JitRegion::JitRegion(const vector<uint8_t> &bytes) {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    size = (bytes.size() + page_size - 1) / page_size * page_size;
+
+    // written first and only then made executable, never both at once
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED)
+        throw runtime_error("Unable to map memory for compiled code");
+    memcpy(mapped, bytes.data(), bytes.size());
+    if (mprotect(mapped, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(mapped, size);
+        throw runtime_error("Unable to make compiled code executable");
+    }
+    code = static_cast<uint8_t *>(mapped);
+}
+
+JitRegion::~JitRegion() {
+    munmap(code, size);
+}
+
+const uint8_t *JitRegion::get_code() const {
+    return code;
+}
+
+
+// just what the compiler emits of x86-64, every jump with a 32 bit displacement
+enum Register { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+enum Condition { BELOW = 0x2, ABOVE_OR_EQUAL = 0x3, EQUAL = 0x4, NOT_EQUAL = 0x5, BELOW_OR_EQUAL = 0x6, ABOVE = 0x7, LESS = 0xc };
+
+class Assembler {
+
+    public:
+
+    using Label = size_t;
+
+    Label label() {
+        labels.push_back(-1);
+        return labels.size() - 1;
+    }
+
+    void bind(Label l) {
+        labels[l] = code.size();
+    }
+
+    size_t offset(Label l) const {
+        return labels[l];
+    }
+
+    // with every jump resolved
+    const vector<uint8_t> &finish() {
+        for (const auto &[at, l]: fixups) {
+            int32_t displacement = static_cast<int32_t>(labels[l] - static_cast<int64_t>(at + 4));
+            memcpy(&code[at], &displacement, 4);
+        }
+        fixups.clear();
+        return code;
+    }
+
+    void mov(Register dst, Register src) {
+        rex(true, src, 0, dst);
+        emit(0x89);
+        emit(0xc0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    void mov(Register dst, int64_t imm) {
+        if (imm >= 0 && imm <= 0xffffffff) {
+            // zero extended
+            rex(false, 0, 0, dst);
+            emit(0xb8 | (dst & 7));
+            imm32(imm);
+        }
+        else if (imm >= INT32_MIN && imm <= INT32_MAX) {
+            rex(true, 0, 0, dst);
+            emit(0xc7);
+            emit(0xc0 | (dst & 7));
+            imm32(imm);
+        }
+        else {
+            rex(true, 0, 0, dst);
+            emit(0xb8 | (dst & 7));
+            for (int i{}; i<8; ++i)
+                emit(static_cast<uint64_t>(imm) >> (8 * i));
+        }
+    }
+
+    void load(Register dst, Register base, int32_t disp) {
+        rex(true, dst, 0, base);
+        emit(0x8b);
+        memory(dst, base, disp);
+    }
+
+    void store(Register base, int32_t disp, Register src) {
+        rex(true, src, 0, base);
+        emit(0x89);
+        memory(src, base, disp);
+    }
+
+    void store(Register base, int32_t disp, int32_t imm) {
+        rex(true, 0, 0, base);
+        emit(0xc7);
+        memory(0, base, disp);
+        imm32(imm);
+    }
+
+    // [base + index * 8]
+    void load_indexed(Register dst, Register base, Register index) {
+        rex(true, dst, index, base);
+        emit(0x8b);
+        indexed(dst, base, index, 3);
+    }
+
+    void store_indexed(Register base, Register index, Register src) {
+        rex(true, src, index, base);
+        emit(0x89);
+        indexed(src, base, index, 3);
+    }
+
+    // byte [base + index] against 0
+    void cmp_byte_zero_indexed(Register base, Register index) {
+        rex(false, 0, index, base);
+        emit(0x80);
+        indexed(7, base, index, 0);
+        emit(0);
+    }
+
+    void cmp_byte_zero(Register base, int32_t disp) {
+        rex(false, 0, 0, base);
+        emit(0x80);
+        memory(7, base, disp);
+        emit(0);
+    }
+
+    void add(Register dst, Register src) { registers(0x01, dst, src); }
+    void cmp(Register a, Register b) { registers(0x39, a, b); }
+    void test(Register a, Register b) { registers(0x85, a, b); }
+
+    // the low 32 bits only, for the ints helpers return
+    void test32(Register r) {
+        rex(false, r, 0, r);
+        emit(0x85);
+        emit(0xc0 | (r & 7) << 3 | (r & 7));
+    }
+
+    void imul(Register dst, Register src) {
+        rex(true, dst, 0, src);
+        emit(0x0f);
+        emit(0xaf);
+        emit(0xc0 | (dst & 7) << 3 | (src & 7));
+    }
+
+    void add(Register dst, int32_t imm) { immediate(0, dst, imm); }
+    void and_(Register dst, int32_t imm) { immediate(4, dst, imm); }
+    void cmp(Register dst, int32_t imm) { immediate(7, dst, imm); }
+
+    // register against qword [base + disp], and the other way around
+    void cmp(Register a, Register base, int32_t disp) {
+        rex(true, a, 0, base);
+        emit(0x3b);
+        memory(a, base, disp);
+    }
+
+    void cmp(Register base, int32_t disp, int32_t imm) {
+        rex(true, 0, 0, base);
+        emit(0x81);
+        memory(7, base, disp);
+        imm32(imm);
+    }
+
+    void shr(Register dst, uint8_t bits) {
+        rex(true, 0, 0, dst);
+        emit(0xc1);
+        emit(0xe8 | (dst & 7));
+        emit(bits);
+    }
+
+    void inc(Register dst) {
+        rex(true, 0, 0, dst);
+        emit(0xff);
+        emit(0xc0 | (dst & 7));
+    }
+
+    // rax = condition ? 1 : 0
+    void set_rax(Condition condition) {
+        emit(0x0f);
+        emit(0x90 | condition);
+        emit(0xc0);
+        emit(0x0f);
+        emit(0xb6);
+        emit(0xc0);
+    }
+
+    void jump(Condition condition, Label l) {
+        emit(0x0f);
+        emit(0x80 | condition);
+        fixup(l);
+    }
+
+    void jump(Label l) {
+        emit(0xe9);
+        fixup(l);
+    }
+
+    void jump(Register r) {
+        rex(false, 0, 0, r);
+        emit(0xff);
+        emit(0xe0 | (r & 7));
+    }
+
+    void call(Register r) {
+        rex(false, 0, 0, r);
+        emit(0xff);
+        emit(0xd0 | (r & 7));
+    }
+
+    void push(Register r) {
+        rex(false, 0, 0, r);
+        emit(0x50 | (r & 7));
+    }
+
+    void pop(Register r) {
+        rex(false, 0, 0, r);
+        emit(0x58 | (r & 7));
+    }
+
+    void ret() {
+        emit(0xc3);
+    }
+
+    private:
+
+    void emit(uint8_t byte) {
+        code.push_back(byte);
+    }
+
+    void imm32(int64_t imm) {
+        for (int i{}; i<4; ++i)
+            emit(static_cast<uint64_t>(imm) >> (8 * i));
+    }
+
+    void fixup(Label l) {
+        fixups.emplace_back(code.size(), l);
+        imm32(0);
+    }
+
+    void rex(bool wide, int reg, int index, int base) {
+        uint8_t prefix = 0x40 | wide << 3 | (reg >> 3) << 2 | (index >> 3) << 1 | (base >> 3);
+        if (prefix != 0x40)
+            emit(prefix);
+    }
+
+    // [base + disp32]
+    void memory(int reg, Register base, int32_t disp) {
+        emit(0x80 | (reg & 7) << 3 | (base & 7));
+        if ((base & 7) == RSP)
+            emit(0x24);
+        imm32(disp);
+    }
+
+    void indexed(int reg, Register base, Register index, int scale) {
+        // no base without a displacement for these two
+        bool needs_displacement = (base & 7) == RBP;
+        emit((needs_displacement ? 0x44 : 0x04) | (reg & 7) << 3);
+        emit(scale << 6 | (index & 7) << 3 | (base & 7));
+        if (needs_displacement)
+            emit(0);
+    }
+
+    void registers(uint8_t opcode, Register dst, Register src) {
+        rex(true, src, 0, dst);
+        emit(opcode);
+        emit(0xc0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    void immediate(int extension, Register dst, int32_t imm) {
+        rex(true, 0, 0, dst);
+        emit(0x81);
+        emit(0xc0 | extension << 3 | (dst & 7));
+        imm32(imm);
+    }
+
+    vector<uint8_t> code;
+    vector<int64_t> labels;
+    vector<pair<size_t, Label>> fixups;
+};
+
+
+// the state of one run besides the frame compiled code sees, and the helpers it calls
+struct JitRunner {
+
+    JitRunner(IntcodeComputer &computer, bool stop_on_output) : computer(computer), stop_on_output(stop_on_output) {
+        frame.runner = this;
+    }
+
+    // the views of the frame, after the pages or the code changed
+    void refresh() {
+        const Memory &memory = computer.memory;
+        readable.assign(memory.pages.size(), nullptr);
+        writable.assign(memory.pages.size(), nullptr);
+        for (size_t page{}; page<memory.pages.size(); ++page) {
+            if (!memory.pages[page])
+                continue;
+            readable[page] = memory.pages[page]->data();
+            if (memory.pages[page].use_count() == 1)
+                writable[page] = readable[page];
+        }
+        frame.readable = readable.data();
+        frame.writable = writable.data();
+        frame.q_pages = readable.size();
+
+        const JitCode &code = *memory.jit;
+        frame.watch = code.watch.data();
+        frame.watch_size = code.watch.size();
+        frame.entries = code.entries.data();
+        frame.q_entries = code.entries.size();
+    }
+
+    static Value read(JitFrame *frame, Address address) {
+        return frame->runner->computer.memory.get(address);
+    }
+
+    static int write(JitFrame *frame, Address address, Value value) {
+        JitRunner &runner = *frame->runner;
+        Memory &memory = runner.computer.memory;
+        memory.jit_invalidated = false;
+        try {
+            memory.set(address, value);
+        }
+        catch (...) {
+            runner.error = current_exception();
+            return EXIT_ERROR;
+        }
+        runner.refresh();
+        // the block writing may be among the ones dropped
+        return memory.jit_invalidated ? EXIT_CONTINUE : 0;
+    }
+
+    // 1 with the value in the frame, 0 when there is none
+    static int input(JitFrame *frame) {
+        IntcodeComputer &computer = frame->runner->computer;
+        if (!computer.input.empty()) {
+            frame->input = computer.input.front();
+            computer.input.pop();
+            return 1;
+        }
+        if (computer.input_span != computer.input_span_end) {
+            frame->input = *computer.input_span++;
+            return 1;
+        }
+        return 0;
+    }
+
+    static int output(JitFrame *frame, Value value) {
+        JitRunner &runner = *frame->runner;
+        IntcodeComputer &computer = runner.computer;
+        try {
+            if (computer.output_sink) {
+                (*computer.output_sink)(value);
+                // a sink may fork the computer, sharing pages it owned so far
+                runner.refresh();
+            }
+            else {
+                computer.output.push(value);
+            }
+        }
+        catch (...) {
+            runner.error = current_exception();
+            return EXIT_ERROR;
+        }
+        return runner.stop_on_output ? EXIT_OUTPUT : 0;
+    }
+
+    IntcodeComputer &computer;
+    bool stop_on_output;
+    JitFrame frame{};
+    vector<Value *> readable;
+    vector<Value *> writable;
+    // thrown in a helper, rethrown once out of compiled code
+    exception_ptr error;
+};
+
+
+#define FRAME(field) static_cast<int32_t>(offsetof(JitFrame, field))
+
+// compiled code runs with the frame in rbx, the relative base in r12 and the instructions it
+// executed in r15; r13 and r14 hold values across helper calls, rax, rcx, rdx, rsi and rdi
+// are scratch
+using JitEntry = int (*)(JitFrame *, const uint8_t *);
+
+// saves the registers compiled code uses, loads them and jumps to the block; each region has
+// the epilogue coming back out of it
+static JitEntry get_entry() {
+    static const JitRegion trampoline{[] {
+        Assembler a;
+        for (Register r: {RBX, R12, R13, R14, R15})
+            a.push(r);
+        a.mov(RBX, RDI);
+        a.load(R12, RBX, FRAME(relative_base));
+        a.mov(R15, 0);
+        a.jump(RSI);
+        return a.finish();
+    }()};
+    return reinterpret_cast<JitEntry>(const_cast<uint8_t *>(trampoline.get_code()));
+}
+
+
+class JitCompiler {
+
+    public:
+
+    JitCompiler(Memory &memory, const JitCode &code) : memory(memory), code(code) {
+        leave = assembler.label();
+        epilogue = assembler.label();
+    }
+
+    // the block starting at the address and as many of those reachable from it through
+    // constant jumps as fit in a region; false if there is no instruction it can compile there
+    bool compile(Address start) {
+        Instruction instruction;
+        if (!decode(start, instruction))
+            return false;
+
+        vector<Address> pending{start};
+        vector<Address> seen;
+        while (!pending.empty() && blocks.size() < MAX_REGION_BLOCKS) {
+            Address begin = pending.back();
+            pending.pop_back();
+            if (find(seen.begin(), seen.end(), begin) != seen.end())
+                continue;
+            seen.push_back(begin);
+            bool has_entry = begin >= 0 && static_cast<size_t>(begin) < code.entries.size() && code.entries[begin];
+            if (has_entry || !decode(begin, instruction))
+                continue;
+            compile_block(begin, pending);
+        }
+
+        write_exits();
+        return true;
+    }
+
+    // maps the region and points the entries of the blocks at it
+    void install(JitCode &target) {
+        auto region = make_shared<JitRegion>(assembler.finish());
+        for (const Block &block: blocks) {
+            if (target.entries.size() <= static_cast<size_t>(block.begin))
+                target.entries.resize(block.begin + 1);
+            if (target.watch.size() < static_cast<size_t>(block.end))
+                target.watch.resize(block.end);
+
+            const uint8_t *body = region->get_code() + assembler.offset(block.body);
+            target.entries[block.begin] = body;
+            target.blocks.push_back({block.begin, block.end, body, true});
+            for (Address word{block.begin}; word<block.end; ++word)
+                target.watch[word] |= WATCH_COMPILED;
+        }
+        target.regions.push_back(move(region));
+    }
+
+    private:
+
+    struct Block {
+        Address begin;
+        Address end;
+        Assembler::Label body;
+    };
+
+    struct Exit {
+        Assembler::Label label;
+        Address ip;
+        // 0 to leave the one a helper returned in eax
+        int status;
+    };
+
+    // one it can compile: known opcode, valid modes, nothing written to an immediate, and no
+    // word marked volatile; anything else is left for the interpreter to run or to report
+    bool decode(Address address, Instruction &instruction) {
+        if (address < 0 || address >= JIT_MAX_ADDRESS)
+            return false;
+        instruction = Instruction::decode(memory.get(address));
+        if (!instruction.handler)
+            return false;
+        if (address + instruction.q_params >= JIT_MAX_ADDRESS)
+            return false;
+
+        for (int i{}; i<instruction.q_params; ++i) {
+            instruction.params[i] = memory.get(address + 1 + i);
+            if (instruction.modes[i] > 2)
+                return false;
+        }
+        switch (instruction.opcode) {
+            case 1: case 2: case 3: case 7: case 8:
+                if (instruction.modes[instruction.q_params - 1] == 1)
+                    return false;
+        }
+
+        for (Address word{address}; word<=address + instruction.q_params; ++word)
+            if (static_cast<size_t>(word) < code.watch.size() && (code.watch[word] & WATCH_VOLATILE))
+                return false;
+        return true;
+    }
+
+    void compile_block(Address begin, vector<Address> &pending) {
+        Assembler &a = assembler;
+        Assembler::Label body = a.label();
+        a.bind(body);
+
+        Address address{begin};
+        Instruction instruction;
+        for (uint64_t q_instructions{}; q_instructions<JIT_MAX_BLOCK_INSTRUCTIONS && decode(address, instruction); ++q_instructions) {
+            Address next = address + 1 + instruction.q_params;
+            switch (instruction.opcode) {
+                case 1: case 2: case 7: case 8:
+                    read_param(instruction, 0);
+                    a.mov(R14, RAX);
+                    read_param(instruction, 1);
+                    if (instruction.opcode == 1) {
+                        a.add(RAX, R14);
+                    }
+                    else if (instruction.opcode == 2) {
+                        a.imul(RAX, R14);
+                    }
+                    else {
+                        a.cmp(R14, RAX);
+                        a.set_rax(instruction.opcode == 7 ? LESS : EQUAL);
+                    }
+                    a.mov(R13, RAX);
+                    a.inc(R15);
+                    write_param(instruction, 2, next);
+                    break;
+
+                case 3:
+                    // suspends on the input instruction itself, not counting it
+                    call(reinterpret_cast<void *>(&JitRunner::input));
+                    a.test32(RAX);
+                    a.jump(EQUAL, exit(address, EXIT_NEEDS_INPUT));
+                    a.load(R13, RBX, FRAME(input));
+                    a.inc(R15);
+                    write_param(instruction, 0, next);
+                    break;
+
+                case 4:
+                    read_param(instruction, 0);
+                    a.mov(RSI, RAX);
+                    call(reinterpret_cast<void *>(&JitRunner::output));
+                    a.inc(R15);
+                    a.test32(RAX);
+                    a.jump(NOT_EQUAL, exit(next, 0));
+                    break;
+
+                case 5: case 6:
+                    compile_jump(instruction, next, pending);
+                    blocks.push_back({begin, next, body});
+                    return;
+
+                case 9:
+                    read_param(instruction, 0);
+                    a.add(R12, RAX);
+                    a.inc(R15);
+                    break;
+
+                case 99:
+                    a.inc(R15);
+                    a.jump(exit(address, EXIT_HALTED));
+                    blocks.push_back({begin, next, body});
+                    return;
+            }
+            address = next;
+        }
+
+        // long enough, or what follows is left to the interpreter
+        chain(address);
+        pending.push_back(address);
+        blocks.push_back({begin, address, body});
+    }
+
+    void compile_jump(const Instruction &instruction, Address next, vector<Address> &pending) {
+        Assembler &a = assembler;
+        const bool if_true = instruction.opcode == 5;
+
+        auto jump_to_target = [&]() {
+            if (instruction.modes[1] == 1) {
+                chain(instruction.params[1]);
+                pending.push_back(instruction.params[1]);
+            }
+            else {
+                read_param(instruction, 1);
+                chain_rax();
+            }
+        };
+
+        if (instruction.modes[0] == 1) {
+            a.inc(R15);
+            if ((instruction.params[0] != 0) == if_true) {
+                jump_to_target();
+                return;
+            }
+        }
+        else {
+            read_param(instruction, 0);
+            a.inc(R15);
+            a.test(RAX, RAX);
+            Assembler::Label not_taken = a.label();
+            a.jump(if_true ? EQUAL : NOT_EQUAL, not_taken);
+            jump_to_target();
+            a.bind(not_taken);
+        }
+        chain(next);
+        pending.push_back(next);
+    }
+
+    void call(void *helper) {
+        assembler.mov(RDI, RBX);
+        assembler.mov(RAX, reinterpret_cast<int64_t>(helper));
+        assembler.call(RAX);
+    }
+
+    // rax = param
+    void read_param(const Instruction &instruction, int i) {
+        Value param = instruction.params[i];
+        switch (instruction.modes[i]) {
+            case 0:
+                read_at(param);
+                break;
+
+            case 1:
+                assembler.mov(RAX, param);
+                break;
+
+            default:
+                relative_address(param);
+                read_rax();
+        }
+    }
+
+    // r13 to where the param points
+    void write_param(const Instruction &instruction, int i, Address next) {
+        Value param = instruction.params[i];
+        if (instruction.modes[i] == 0) {
+            write_at(param, next);
+        }
+        else {
+            relative_address(param);
+            write_rax(next);
+        }
+    }
+
+    void relative_address(Value offset) {
+        assembler.mov(RAX, R12);
+        if (offset >= INT32_MIN && offset <= INT32_MAX) {
+            assembler.add(RAX, static_cast<int32_t>(offset));
+        }
+        else {
+            assembler.mov(RCX, offset);
+            assembler.add(RAX, RCX);
+        }
+    }
+
+    // missing pages and anything past the page table go through the Memory
+    void read_at(Address address) {
+        Assembler &a = assembler;
+        if (address >= 0 && address < JIT_MAX_ADDRESS) {
+            Assembler::Label slow = a.label(), done = a.label();
+            int32_t page = address >> PAGE_BITS;
+            int32_t offset = address & (PAGE_SIZE - 1);
+            a.cmp(RBX, FRAME(q_pages), page);
+            a.jump(BELOW_OR_EQUAL, slow);
+            a.load(RCX, RBX, FRAME(readable));
+            a.load(RCX, RCX, page * 8);
+            a.test(RCX, RCX);
+            a.jump(EQUAL, slow);
+            a.load(RAX, RCX, offset * 8);
+            a.jump(done);
+            a.bind(slow);
+            a.mov(RSI, address);
+            call(reinterpret_cast<void *>(&JitRunner::read));
+            a.bind(done);
+        }
+        else {
+            a.mov(RSI, address);
+            call(reinterpret_cast<void *>(&JitRunner::read));
+        }
+    }
+
+    void read_rax() {
+        Assembler &a = assembler;
+        Assembler::Label slow = a.label(), done = a.label();
+        a.mov(RDX, RAX);
+        a.shr(RDX, PAGE_BITS);
+        a.cmp(RDX, RBX, FRAME(q_pages));
+        a.jump(ABOVE_OR_EQUAL, slow);
+        a.load(RCX, RBX, FRAME(readable));
+        a.load_indexed(RCX, RCX, RDX);
+        a.test(RCX, RCX);
+        a.jump(EQUAL, slow);
+        a.and_(RAX, PAGE_SIZE - 1);
+        a.load_indexed(RAX, RCX, RAX);
+        a.jump(done);
+        a.bind(slow);
+        a.mov(RSI, RAX);
+        call(reinterpret_cast<void *>(&JitRunner::read));
+        a.bind(done);
+    }
+
+    // stored in place unless the word is watched or the page isn't this computer's alone, in
+    // which case the Memory does it and the block is left if it dropped any code
+    void write_at(Address address, Address next) {
+        Assembler &a = assembler;
+        Assembler::Label slow = a.label(), done = a.label();
+        if (address >= 0 && address < JIT_MAX_ADDRESS) {
+            Assembler::Label unwatched = a.label();
+            int32_t page = address >> PAGE_BITS;
+            int32_t offset = address & (PAGE_SIZE - 1);
+            a.cmp(RBX, FRAME(watch_size), address);
+            a.jump(BELOW_OR_EQUAL, unwatched);
+            a.load(RDX, RBX, FRAME(watch));
+            a.cmp_byte_zero(RDX, address);
+            a.jump(NOT_EQUAL, slow);
+            a.bind(unwatched);
+            a.cmp(RBX, FRAME(q_pages), page);
+            a.jump(BELOW_OR_EQUAL, slow);
+            a.load(RCX, RBX, FRAME(writable));
+            a.load(RCX, RCX, page * 8);
+            a.test(RCX, RCX);
+            a.jump(EQUAL, slow);
+            a.store(RCX, offset * 8, R13);
+            a.jump(done);
+        }
+        a.bind(slow);
+        a.mov(RSI, address);
+        a.mov(RDX, R13);
+        call(reinterpret_cast<void *>(&JitRunner::write));
+        a.test32(RAX);
+        a.jump(NOT_EQUAL, exit(next, 0));
+        a.bind(done);
+    }
+
+    void write_rax(Address next) {
+        Assembler &a = assembler;
+        Assembler::Label slow = a.label(), done = a.label(), beyond = a.label(), unwatched = a.label();
+        a.cmp(RAX, RBX, FRAME(watch_size));
+        a.jump(ABOVE_OR_EQUAL, beyond);
+        a.load(RDX, RBX, FRAME(watch));
+        a.cmp_byte_zero_indexed(RDX, RAX);
+        a.jump(NOT_EQUAL, slow);
+        a.jump(unwatched);
+        // nothing is watched past the end, but nothing is compiled past the limit either
+        a.bind(beyond);
+        a.cmp(RAX, static_cast<int32_t>(JIT_MAX_ADDRESS));
+        a.jump(ABOVE_OR_EQUAL, slow);
+        a.bind(unwatched);
+        a.mov(RDX, RAX);
+        a.shr(RDX, PAGE_BITS);
+        a.cmp(RDX, RBX, FRAME(q_pages));
+        a.jump(ABOVE_OR_EQUAL, slow);
+        a.load(RCX, RBX, FRAME(writable));
+        a.load_indexed(RCX, RCX, RDX);
+        a.test(RCX, RCX);
+        a.jump(EQUAL, slow);
+        a.and_(RAX, PAGE_SIZE - 1);
+        a.store_indexed(RCX, RAX, R13);
+        a.jump(done);
+        a.bind(slow);
+        a.mov(RSI, RAX);
+        a.mov(RDX, R13);
+        call(reinterpret_cast<void *>(&JitRunner::write));
+        a.test32(RAX);
+        a.jump(NOT_EQUAL, exit(next, 0));
+        a.bind(done);
+    }
+
+    // on to the block at the address through the entry table, or back to the dispatch loop if
+    // there is none yet or the budget may not cover it
+    void chain(Address address) {
+        Assembler &a = assembler;
+        if (address < 0 || address >= JIT_MAX_ADDRESS) {
+            a.jump(exit(address, EXIT_CONTINUE));
+            return;
+        }
+        a.store(RBX, FRAME(ip), static_cast<int32_t>(address));
+        a.cmp(R15, RBX, FRAME(chain_limit));
+        a.jump(ABOVE, leave);
+        a.cmp(RBX, FRAME(q_entries), static_cast<int32_t>(address));
+        a.jump(BELOW_OR_EQUAL, leave);
+        a.load(RCX, RBX, FRAME(entries));
+        a.load(RCX, RCX, address * 8);
+        a.test(RCX, RCX);
+        a.jump(EQUAL, leave);
+        a.jump(RCX);
+    }
+
+    void chain_rax() {
+        Assembler &a = assembler;
+        a.store(RBX, FRAME(ip), RAX);
+        a.cmp(R15, RBX, FRAME(chain_limit));
+        a.jump(ABOVE, leave);
+        a.cmp(RAX, RBX, FRAME(q_entries));
+        a.jump(ABOVE_OR_EQUAL, leave);
+        a.load(RCX, RBX, FRAME(entries));
+        a.load_indexed(RCX, RCX, RAX);
+        a.test(RCX, RCX);
+        a.jump(EQUAL, leave);
+        a.jump(RCX);
+    }
+
+    Assembler::Label exit(Address ip, int status) {
+        exits.push_back({assembler.label(), ip, status});
+        return exits.back().label;
+    }
+
+    // out of the way after the blocks: setting the ip and status, then the epilogue
+    void write_exits() {
+        Assembler &a = assembler;
+        for (const Exit &e: exits) {
+            a.bind(e.label);
+            if (e.ip >= INT32_MIN && e.ip <= INT32_MAX) {
+                a.store(RBX, FRAME(ip), static_cast<int32_t>(e.ip));
+            }
+            else {
+                a.mov(RCX, e.ip);
+                a.store(RBX, FRAME(ip), RCX);
+            }
+            if (e.status)
+                a.mov(RAX, e.status);
+            a.jump(epilogue);
+        }
+
+        // the ip is already set
+        a.bind(leave);
+        a.mov(RAX, EXIT_CONTINUE);
+        a.bind(epilogue);
+        a.store(RBX, FRAME(relative_base), R12);
+        a.store(RBX, FRAME(q_executed), R15);
+        for (Register r: {R15, R14, R13, R12, RBX})
+            a.pop(r);
+        a.ret();
+    }
+
+    Memory &memory;
+    const JitCode &code;
+    Assembler assembler;
+    vector<Block> blocks;
+    vector<Exit> exits;
+    Assembler::Label leave;
+    Assembler::Label epilogue;
+};
+
+#undef FRAME
+
+
+JitCode &Memory::writable_jit() {
+    if (jit.use_count() > 1)
+        // shared with a fork, copy on write
+        jit = make_shared<JitCode>(*jit);
+    return *jit;
+}
+
+void Memory::invalidate_compiled(Address address) {
+    if (static_cast<size_t>(address) >= jit->watch.size() || !(jit->watch[address] & WATCH_COMPILED))
+        return;
+
+    JitCode &code = writable_jit();
+    bool dropped{false};
+    for (auto &block: code.blocks) {
+        if (block.live && block.begin <= address && address < block.end) {
+            block.live = false;
+            code.entries[block.begin] = nullptr;
+            dropped = true;
+        }
+    }
+
+    // otherwise a bit left behind by a block dropped earlier
+    code.watch[address] &= ~WATCH_COMPILED;
+    if (dropped) {
+        code.watch[address] |= WATCH_VOLATILE;
+        jit_invalidated = true;
+    }
+}
+
+const uint8_t *Memory::compiled(Address address) {
+    if (address < 0 || address >= JIT_MAX_ADDRESS)
+        return nullptr;
+    if (static_cast<size_t>(address) < jit->entries.size() && jit->entries[address])
+        return jit->entries[address];
+
+    JitCompiler compiler{*this, *jit};
+    if (!compiler.compile(address))
+        return nullptr;
+    compiler.install(writable_jit());
+    return jit->entries[address];
+}
+
+// the words of an instruction going into the decode cache, [begin, end)
+void Memory::watch_decoded(Address begin, Address end) {
+    end = min(end, JIT_MAX_ADDRESS);
+    if (begin < 0 || begin >= end)
+        return;
+
+    bool watched = static_cast<size_t>(end) <= jit->watch.size() &&
+                   all_of(jit->watch.begin() + begin, jit->watch.begin() + end, [](uint8_t w) { return w & WATCH_DECODED; });
+    if (watched)
+        return;
+
+    JitCode &code = writable_jit();
+    if (code.watch.size() < static_cast<size_t>(end))
+        code.watch.resize(end);
+    for (Address word{begin}; word<end; ++word)
+        code.watch[word] |= WATCH_DECODED;
+}
+
+
+bool IntcodeComputer::enable_jit() {
+    if (!memory.jit) {
+        memory.jit = make_shared<JitCode>();
+        // nothing decoded so far is watched, so it's decoded again
+        memory.decoded.clear();
+    }
+    return true;
+}
+
+RunStatus IntcodeComputer::execute_compiled(uint64_t budget, bool stop_on_output) {
+    static const JitEntry enter = get_entry();
+    JitRunner runner{*this, stop_on_output};
+    const uint64_t q_executed_before{q_executed};
+
+    while (true) {
+        const uint64_t q_dispatched = q_executed - q_executed_before;
+        if (q_dispatched >= budget)
+            return RunStatus::budget_exhausted;
+
+        // whole blocks while the budget is sure to cover them, then one instruction at a time
+        const uint64_t q_left = budget - q_dispatched;
+        const uint8_t *body = q_left >= JIT_MAX_BLOCK_INSTRUCTIONS ? memory.compiled(ip) : nullptr;
+        if (!body) {
+            RunStatus status = interpret(1, stop_on_output);
+            if (status != RunStatus::budget_exhausted)
+                return status;
+            continue;
+        }
+
+        runner.refresh();
+        runner.frame.ip = ip;
+        runner.frame.relative_base = relative_base;
+        runner.frame.chain_limit = q_left - JIT_MAX_BLOCK_INSTRUCTIONS;
+        const int exit = enter(&runner.frame, body);
+        ip = runner.frame.ip;
+        relative_base = runner.frame.relative_base;
+        q_executed += runner.frame.q_executed;
+        q_native += runner.frame.q_executed;
+
+        switch (exit) {
+            case EXIT_CONTINUE:
+                break;
+
+            case EXIT_NEEDS_INPUT:
+                return RunStatus::needs_input;
+
+            case EXIT_HALTED:
+                terminated = true;
+                return RunStatus::halted;
+
+            case EXIT_OUTPUT:
+                return RunStatus::output_available;
+
+            default:
+                rethrow_exception(runner.error);
+        }
+    }
+}
+
+#else
+
+bool IntcodeComputer::enable_jit() {
+    return false;
+}
+
+#endif
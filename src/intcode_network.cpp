@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "intcode_network.hpp"
+
+
+using namespace std;
+
+
+// instructions a computer runs before giving way to the others in the ready queue
+static const uint64_t TIME_SLICE{100000};
+
+
+size_t IntcodeNetwork::add(IntcodeComputer computer) {
+    nodes.push_back(make_unique<Node>(computer));
+    return nodes.size() - 1;
+}
+
+void IntcodeNetwork::connect(size_t from, size_t to) {
+    assert(from < nodes.size() && to < nodes.size());
+    nodes[from]->connected = true;
+    nodes[from]->next = to;
+}
+
+IntcodeComputer &IntcodeNetwork::computer(size_t id) {
+    return nodes.at(id)->computer;
+}
+
+const vector<Value> &IntcodeNetwork::outputs(size_t id) const {
+    return nodes.at(id)->outputs;
+}
+
+Value IntcodeNetwork::last_output(size_t id) const {
+    return nodes.at(id)->last_output;
+}
+
+size_t IntcodeNetwork::size() const {
+    return nodes.size();
+}
+
+void IntcodeNetwork::send(size_t to, Value value) {
+    deliver(to, value);
+}
+
+void IntcodeNetwork::deliver(size_t to, Value value) {
+    Node &node = *nodes.at(to);
+    bool wake{false};
+    {
+        lock_guard<mutex> guard{node.lock};
+        node.mailbox.push_back(value);
+        if (node.state == NodeState::idle && !node.computer.has_terminated()) {
+            node.state = NodeState::queued;
+            wake = true;
+        }
+    }
+
+    if (wake)
+        schedule(to);
+}
+
+void IntcodeNetwork::schedule(size_t id) {
+    {
+        lock_guard<mutex> guard{scheduler_lock};
+        ready.push_back(id);
+        ++q_busy;
+    }
+    scheduler_signal.notify_one();
+}
+
+void IntcodeNetwork::run_node(size_t id) {
+    Node &node = *nodes[id];
+
+    {
+        lock_guard<mutex> guard{node.lock};
+        node.state = NodeState::running;
+        node.started = true;
+        for (auto value: node.mailbox)
+            node.computer.push_input(value);
+        node.mailbox.clear();
+    }
+
+    // runs until it halts, needs input nobody has sent yet or uses up its slice,
+    // passing each output on as soon as it is produced
+    RunStatus status;
+    uint64_t q_left{TIME_SLICE};
+    do {
+        uint64_t q_before = node.computer.instructions_executed();
+        status = node.computer.run(q_left);
+        q_left -= min(q_left, node.computer.instructions_executed() - q_before);
+
+        while (node.computer.output_size()) {
+            node.last_output = node.computer.pop_output();
+            if (node.connected)
+                deliver(node.next, node.last_output);
+            else
+                node.outputs.push_back(node.last_output);
+        }
+    } while (status == RunStatus::output_available);
+
+    bool requeue{false};
+    {
+        lock_guard<mutex> guard{node.lock};
+        // input arrived while it was running, or it still has work left
+        if (status == RunStatus::budget_exhausted || (!node.mailbox.empty() && !node.computer.has_terminated())) {
+            node.state = NodeState::queued;
+            requeue = true;
+        }
+        else {
+            node.state = NodeState::idle;
+        }
+    }
+
+    {
+        lock_guard<mutex> guard{scheduler_lock};
+        if (requeue)
+            // still busy, no change in the count
+            ready.push_back(id);
+        else
+            --q_busy;
+    }
+    scheduler_signal.notify_all();
+}
+
+void IntcodeNetwork::work() {
+    while (true) {
+        size_t id;
+        {
+            unique_lock<mutex> guard{scheduler_lock};
+            scheduler_signal.wait(guard, [this]() { return !ready.empty() || q_busy == 0; });
+            if (ready.empty())
+                // everybody halted or waiting on input that will never come
+                return;
+            id = ready.front();
+            ready.pop_front();
+        }
+
+        run_node(id);
+    }
+}
+
+void IntcodeNetwork::run(size_t q_workers) {
+    assert(q_workers > 0);
+
+    // every computer gets a first run, up to its first input.
+    // those with new input are already in the ready queue
+    {
+        lock_guard<mutex> guard{scheduler_lock};
+        for (size_t id{}; id<nodes.size(); ++id) {
+            Node &node = *nodes[id];
+            lock_guard<mutex> node_guard{node.lock};
+            if (node.state == NodeState::idle && !node.started && !node.computer.has_terminated()) {
+                node.state = NodeState::queued;
+                ready.push_back(id);
+            }
+        }
+        q_busy = ready.size();
+    }
+
+    vector<thread> workers;
+    for (size_t i{}; i<q_workers; ++i)
+        workers.emplace_back(&IntcodeNetwork::work, this);
+    for (auto &worker: workers)
+        worker.join();
+}
@@ -0,0 +1,21 @@
+#include <iostream>
+
+#include "intcode.hpp"
+
+
+using namespace std;
+
+
+// compiles a comma separated Intcode program into the binary format IntcodeComputer::from_file mmaps
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " program.txt program.bin" << endl;
+        return 1;
+    }
+
+    Text text = read_text_program(argv[1]);
+    write_binary_program(text, argv[2]);
+    cout << "Packed " << text.size() << " words into " << argv[2] << endl;
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include <stdexcept>
+#include <string>
+
+#include "intcode_symbolic.hpp"
+
+
+using namespace std;
+
+
+// concrete loops are fine, but they have to end
+static const size_t MAX_SYMBOLIC_STEPS = 10000000;
+static const Address MAX_SYMBOLIC_ADDRESS = Address{1} << 20;
+
+
+SymbolicRun::SymbolicRun(const Text &text, const vector<Address> &patched) : q_unknowns(patched.size()) {
+    if (patched.empty())
+        throw invalid_argument("Symbolic run needs at least one unknown");
+
+    for (auto value: text)
+        cells.push_back(Cell{false, value});
+    for (size_t unknown{}; unknown<patched.size(); ++unknown)
+        write(patched[unknown], make_node(Kind::unknown, unknown));
+
+    Address ip{};
+    for (size_t step{}; ; ++step) {
+        if (step == MAX_SYMBOLIC_STEPS)
+            throw runtime_error("Program runs too long to be solved");
+
+        Instruction instruction = Instruction::decode(concrete(read(ip), "an instruction"));
+        switch (instruction.opcode) {
+            case 1:
+                write(get_write_address(instruction, ip, 3), add(get_read_param(instruction, ip, 1), get_read_param(instruction, ip, 2)));
+                ip += 4;
+                break;
+
+            case 2:
+                write(get_write_address(instruction, ip, 3), multiply(get_read_param(instruction, ip, 1), get_read_param(instruction, ip, 2)));
+                ip += 4;
+                break;
+
+            case 7: case 8: {
+                Cell lhs = get_read_param(instruction, ip, 1);
+                Cell rhs = get_read_param(instruction, ip, 2);
+                Cell result;
+                if (lhs.symbolic || rhs.symbolic)
+                    result = make_node(Kind::opaque, 0);
+                else if (instruction.opcode == 7)
+                    result = Cell{false, lhs.value < rhs.value};
+                else
+                    result = Cell{false, lhs.value == rhs.value};
+                write(get_write_address(instruction, ip, 3), result);
+                ip += 4;
+                break;
+            }
+
+            case 5: case 6: {
+                Value condition = concrete(get_read_param(instruction, ip, 1), "a jump condition");
+                Value target = concrete(get_read_param(instruction, ip, 2), "a jump target");
+                if ((instruction.opcode == 5) == (condition != 0))
+                    ip = static_cast<Address>(target);
+                else
+                    ip += 3;
+                break;
+            }
+
+            case 9:
+                relative_base += concrete(get_read_param(instruction, ip, 1), "the relative base");
+                ip += 2;
+                break;
+
+            case 99:
+                return;
+
+            case 3: case 4:
+                throw runtime_error("Symbolic runs don't take input or produce output");
+
+            default:
+                throw runtime_error("Invalid operation code");
+        }
+    }
+}
+
+
+SymbolicRun::Cell SymbolicRun::make_node(Kind kind, Value value, size_t lhs, size_t rhs) {
+    nodes.push_back(Node{kind, value, lhs, rhs});
+    return Cell{true, static_cast<Value>(nodes.size() - 1)};
+}
+
+SymbolicRun::Cell SymbolicRun::read(Address address) const {
+    if (address < 0)
+        throw runtime_error("Negative address");
+    if (static_cast<size_t>(address) >= cells.size())
+        return Cell{false, 0};
+    return cells[address];
+}
+
+void SymbolicRun::write(Address address, Cell cell) {
+    if (address < 0 || address >= MAX_SYMBOLIC_ADDRESS)
+        throw runtime_error("Address out of range for a symbolic run");
+    if (static_cast<size_t>(address) >= cells.size())
+        cells.resize(address + 1, Cell{false, 0});
+    cells[address] = cell;
+}
+
+Value SymbolicRun::concrete(Cell cell, const char *what) const {
+    if (cell.symbolic)
+        throw runtime_error(string("Program depends on its unknowns for ") + what);
+    return cell.value;
+}
+
+// constants are folded as they go, only expressions of unknowns become nodes
+SymbolicRun::Cell SymbolicRun::add(Cell lhs, Cell rhs) {
+    if (!lhs.symbolic && !rhs.symbolic)
+        return Cell{false, lhs.value + rhs.value};
+    if (!lhs.symbolic && lhs.value == 0)
+        return rhs;
+    if (!rhs.symbolic && rhs.value == 0)
+        return lhs;
+
+    size_t lhs_node = lhs.symbolic ? lhs.value : make_node(Kind::constant, lhs.value).value;
+    size_t rhs_node = rhs.symbolic ? rhs.value : make_node(Kind::constant, rhs.value).value;
+    return make_node(Kind::sum, 0, lhs_node, rhs_node);
+}
+
+SymbolicRun::Cell SymbolicRun::multiply(Cell lhs, Cell rhs) {
+    if (!lhs.symbolic && !rhs.symbolic)
+        return Cell{false, lhs.value * rhs.value};
+    if ((!lhs.symbolic && lhs.value == 0) || (!rhs.symbolic && rhs.value == 0))
+        return Cell{false, 0};
+    if (!lhs.symbolic && lhs.value == 1)
+        return rhs;
+    if (!rhs.symbolic && rhs.value == 1)
+        return lhs;
+
+    size_t lhs_node = lhs.symbolic ? lhs.value : make_node(Kind::constant, lhs.value).value;
+    size_t rhs_node = rhs.symbolic ? rhs.value : make_node(Kind::constant, rhs.value).value;
+    return make_node(Kind::product, 0, lhs_node, rhs_node);
+}
+
+SymbolicRun::Cell SymbolicRun::get_read_param(const Instruction &instruction, Address ip, int offset) {
+    Cell param = read(ip + offset);
+
+    // immediate
+    if (instruction.modes[offset - 1] == 1)
+        return param;
+
+    // the address is an expression, no telling which cell it reads
+    if (param.symbolic)
+        return make_node(Kind::opaque, 0);
+
+    if (instruction.modes[offset - 1] == 0)
+        return read(param.value);
+    if (instruction.modes[offset - 1] == 2)
+        return read(param.value + relative_base);
+
+    throw runtime_error("Invalid parameter mode");
+}
+
+Address SymbolicRun::get_write_address(const Instruction &instruction, Address ip, int offset) const {
+    Value param = concrete(read(ip + offset), "a write address");
+
+    if (instruction.modes[offset - 1] == 0)
+        return param;
+    if (instruction.modes[offset - 1] == 2)
+        return param + relative_base;
+
+    throw runtime_error("Invalid parameter mode for writing");
+}
+
+
+// folds the nodes up to the cell's one into constant plus coefficients of the unknowns
+SymbolicRun::LinearForm SymbolicRun::linear_form(Cell cell) const {
+    if (!cell.symbolic)
+        return LinearForm{true, cell.value, vector<Value>(q_unknowns)};
+
+    size_t root = cell.value;
+    vector<LinearForm> forms(root + 1, LinearForm{true, 0, vector<Value>(q_unknowns)});
+    // opaque values are only an error if the cell depends on them
+    vector<bool> opaque(root + 1);
+
+    for (size_t n{}; n<=root; ++n) {
+        const Node &node = nodes[n];
+        LinearForm &form = forms[n];
+        switch (node.kind) {
+            case Kind::constant:
+                form.constant = node.value;
+                break;
+
+            case Kind::unknown:
+                form.coefficients[node.value] = 1;
+                break;
+
+            case Kind::opaque:
+                opaque[n] = true;
+                break;
+
+            case Kind::sum: {
+                const LinearForm &lhs = forms[node.lhs], &rhs = forms[node.rhs];
+                opaque[n] = opaque[node.lhs] || opaque[node.rhs];
+                form.linear = lhs.linear && rhs.linear;
+                form.constant = lhs.constant + rhs.constant;
+                for (size_t unknown{}; unknown<q_unknowns; ++unknown)
+                    form.coefficients[unknown] = lhs.coefficients[unknown] + rhs.coefficients[unknown];
+                break;
+            }
+
+            case Kind::product: {
+                const LinearForm &lhs = forms[node.lhs], &rhs = forms[node.rhs];
+                opaque[n] = opaque[node.lhs] || opaque[node.rhs];
+                auto is_constant = [](const LinearForm &f) {
+                    for (auto coefficient: f.coefficients)
+                        if (coefficient)
+                            return false;
+                    return f.linear;
+                };
+                if (!is_constant(lhs) && !is_constant(rhs)) {
+                    form.linear = false;
+                    break;
+                }
+                const LinearForm &scale = is_constant(lhs) ? lhs : rhs;
+                const LinearForm &other = is_constant(lhs) ? rhs : lhs;
+                form.linear = other.linear;
+                form.constant = scale.constant * other.constant;
+                for (size_t unknown{}; unknown<q_unknowns; ++unknown)
+                    form.coefficients[unknown] = scale.constant * other.coefficients[unknown];
+                break;
+            }
+        }
+    }
+
+    if (opaque[root])
+        throw runtime_error("Cell depends on a value that can't be expressed");
+    return forms[root];
+}
+
+bool SymbolicRun::is_linear(Address address) const {
+    return linear_form(read(address)).linear;
+}
+
+Value SymbolicRun::evaluate(Address address, const vector<Value> &values) const {
+    if (values.size() != q_unknowns)
+        throw invalid_argument("One value per unknown is needed");
+
+    Cell cell = read(address);
+    if (!cell.symbolic)
+        return cell.value;
+
+    size_t root = cell.value;
+    vector<Value> results(root + 1);
+    vector<bool> opaque(root + 1);
+    for (size_t n{}; n<=root; ++n) {
+        const Node &node = nodes[n];
+        switch (node.kind) {
+            case Kind::constant: results[n] = node.value; break;
+            case Kind::unknown: results[n] = values[node.value]; break;
+            case Kind::opaque: opaque[n] = true; break;
+            case Kind::sum:
+                opaque[n] = opaque[node.lhs] || opaque[node.rhs];
+                results[n] = results[node.lhs] + results[node.rhs];
+                break;
+            case Kind::product:
+                opaque[n] = opaque[node.lhs] || opaque[node.rhs];
+                results[n] = results[node.lhs] * results[node.rhs];
+                break;
+        }
+    }
+
+    if (opaque[root])
+        throw runtime_error("Cell depends on a value that can't be expressed");
+    return results[root];
+}
+
+vector<Value> SymbolicRun::solve(Address address, Value target, const vector<pair<Value, Value>> &ranges) const {
+    if (ranges.size() != q_unknowns)
+        throw invalid_argument("One range per unknown is needed");
+    for (auto &range: ranges)
+        if (range.first > range.second)
+            return {};
+
+    LinearForm form = linear_form(read(address));
+
+    // odometer over the unknowns, all of them unless the last one can be solved for
+    size_t q_enumerated = form.linear ? q_unknowns - 1 : q_unknowns;
+    vector<Value> values(q_unknowns);
+    for (size_t unknown{}; unknown<q_enumerated; ++unknown)
+        values[unknown] = ranges[unknown].first;
+
+    while (true) {
+        if (form.linear) {
+            Value rest = target - form.constant;
+            for (size_t unknown{}; unknown<q_enumerated; ++unknown)
+                rest -= form.coefficients[unknown] * values[unknown];
+
+            Value coefficient = form.coefficients.back();
+            const auto &range = ranges.back();
+            if (coefficient == 0 && rest == 0) {
+                values.back() = range.first;
+                return values;
+            }
+            if (coefficient && rest % coefficient == 0 && rest / coefficient >= range.first && rest / coefficient <= range.second) {
+                values.back() = rest / coefficient;
+                return values;
+            }
+        }
+        else if (evaluate(address, values) == target) {
+            return values;
+        }
+
+        // last unknown fastest, so the first solution found is the lexicographically smallest
+        size_t unknown{q_enumerated};
+        for (; unknown>0; --unknown) {
+            if (values[unknown - 1] < ranges[unknown - 1].second) {
+                ++values[unknown - 1];
+                break;
+            }
+            values[unknown - 1] = ranges[unknown - 1].first;
+        }
+        if (unknown == 0)
+            return {};
+    }
+}
@@ -0,0 +1,41 @@
+#include <cctype>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parse.hpp"
+
+using namespace std;
+
+
+string read_file(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        throw runtime_error(string("Unable to open file ") + string(filename));
+
+    // one read for the whole file
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    string contents(size > 0 ? size : 0, '\0');
+    size_t q_read = fread(contents.data(), 1, contents.size(), file);
+    fclose(file);
+    contents.resize(q_read);
+
+    return contents;
+}
+
+
+vector<int> parse_digits(const char *filename) {
+    const string contents = read_file(filename);
+
+    vector<int> digits;
+    digits.reserve(contents.size());
+    for (const char c: contents)
+        if (isdigit(static_cast<unsigned char>(c)))
+            digits.push_back(c - '0');
+
+    return digits;
+}
@@ -0,0 +1,59 @@
+#include <string>
+
+#include "catch.hpp"
+#include "grid.hpp"
+
+
+TEST_CASE("Grid reads the background until written", "[grid]") {
+    Grid<char> grid{'.'};
+    REQUIRE(grid.empty());
+    REQUIRE(grid.at(Point{3, -7}) == '.');
+
+    grid[Point{3, -7}] = '#';
+    REQUIRE(!grid.empty());
+    REQUIRE(grid.at(Point{3, -7}) == '#');
+    REQUIRE(grid.at(Point{-7, 3}) == '.');
+    REQUIRE(grid.get_min() == Point{3, -7});
+    REQUIRE(grid.get_max() == Point{3, -7});
+}
+
+TEST_CASE("Grid grows in every direction keeping its cells", "[grid]") {
+    Grid<int> grid{-1};
+    // a spiral out from the origin, well past the first chunk on every side
+    Point p{}, direction{1, 0};
+    int value{};
+    for (int length{1}; length<200; ++length) {
+        for (int i{}; i<length; ++i) {
+            grid[p] = value++;
+            p += direction;
+        }
+        direction = direction.left();
+    }
+
+    p = Point{};
+    direction = Point{1, 0};
+    value = 0;
+    for (int length{1}; length<200; ++length) {
+        for (int i{}; i<length; ++i) {
+            REQUIRE(grid.at(p) == value++);
+            p += direction;
+        }
+        direction = direction.left();
+    }
+    REQUIRE(grid.count_if([](int cell) { return cell >= 0; }) == static_cast<size_t>(value));
+    REQUIRE(grid.at(grid.get_max() + Point{1, 1}) == -1);
+}
+
+TEST_CASE("Grid rows for printing", "[grid]") {
+    Grid<char> grid{' '};
+    grid[Point{-1, 5}] = 'a';
+    grid[Point{1, 5}] = 'b';
+    grid[Point{0, 6}] = 'c';
+
+    REQUIRE(string(grid.row(5), 3) == "a b");
+    REQUIRE(string(grid.row(6), 3) == " c ");
+
+    string visited;
+    grid.for_each([&visited](const Point &, char cell) { visited.push_back(cell); });
+    REQUIRE(visited == "a b c ");
+}
@@ -0,0 +1,228 @@
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#include "catch.hpp"
+#include "day5_lib.hpp"
+#include "day7_lib.hpp"
+#include "day11_lib.hpp"
+#include "day13_lib.hpp"
+#include "day15_lib.hpp"
+#include "intcode.hpp"
+
+
+// every allocation in the program goes through here, so a workload's share can be reported
+static size_t q_allocations{};
+
+void *operator new(size_t size) {
+    ++q_allocations;
+    if (void *memory = malloc(size ? size : 1))
+        return memory;
+    throw bad_alloc();
+}
+
+// the sized and array forms end up here too. kept out of line, as gcc takes the free() inlined
+// into a caller for one on memory from operator new
+[[gnu::noinline]] void operator delete(void *memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    operator delete(memory);
+}
+
+
+// puzzle inputs are not part of the repo, drop them in inputs/ to benchmark them
+bool has_input(const char *filename) {
+    ifstream file{filename};
+    if (!file.is_open())
+        WARN("Skipping, missing " << filename);
+    return file.is_open();
+}
+
+
+// a workload runs a day's core loop once and returns the instructions its computers executed
+using Workload = function<uint64_t()>;
+
+// Catch times the workloads but can't relate that to the work done, so each one is also run
+// here: best of a few runs for the per instruction figures, allocations of a single run
+void report(const char *name, const Workload &workload) {
+    const int q_runs{3};
+    double best_seconds{};
+    uint64_t q_instructions{};
+    size_t q_run_allocations{};
+
+    for (int run{}; run<q_runs; ++run) {
+        size_t q_allocations_before = q_allocations;
+        auto start = chrono::steady_clock::now();
+        q_instructions = workload();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        q_run_allocations = q_allocations - q_allocations_before;
+        if (!run || seconds < best_seconds)
+            best_seconds = seconds;
+    }
+
+    cout << name << ": " << q_instructions << " instructions, "
+         << best_seconds * 1e9 / q_instructions << " ns/instruction, "
+         << q_instructions / best_seconds / 1e6 << " M instructions/s, "
+         << q_run_allocations << " allocations" << endl;
+}
+
+void measure(const char *name, const Workload &workload) {
+    report(name, workload);
+    BENCHMARK(name) {
+        return workload();
+    };
+}
+
+
+// sums 0..N-1 for N read from input, keeping the sum in the relative base frame
+const Text sum_loop{
+    109,1000, 3,100, 1101,0,0,101, 21101,0,0,0, 7,101,100,103, 1006,103,33,
+    20201,0,101,0, 1001,101,1,101, 1105,1,12, 0,0,0, 204,0, 99
+};
+
+
+TEST_CASE("Synthetic loop", "[intcode][bench]") {
+    measure("sum loop, 100k iterations", [] {
+        IntcodeComputer computer{0, sum_loop};
+        computer.push_input(100000);
+        computer.run();
+        return computer.instructions_executed();
+    });
+}
+
+TEST_CASE("Day 5 diagnostics", "[intcode][bench]") {
+    const char *filename = "inputs/day5.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("air conditioner and thermal radiator ids", [&text] {
+        uint64_t q_instructions{};
+        for (Value system: {AIR_CONDITIONER_ID, THERMAL_RADIATOR_ID}) {
+            IntcodeComputer computer{0, text};
+            run_diagnostic(computer, system);
+            q_instructions += computer.instructions_executed();
+        }
+        return q_instructions;
+    });
+}
+
+TEST_CASE("Day 7 amplifiers", "[intcode][bench]") {
+    const char *filename = "inputs/day7.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("every phase permutation in series", [&text] {
+        atomic<uint64_t> q_instructions{};
+        get_max_series_thruster_signal(text, {0, 1, 2, 3, 4}, &q_instructions);
+        return q_instructions.load();
+    });
+
+    measure("every phase permutation in a feedback loop", [&text] {
+        atomic<uint64_t> q_instructions{};
+        vector<Value> phases{5, 6, 7, 8, 9};
+        get_max_feedback_thruster_signal(text, phases, get_feedback_thruster_signal, &q_instructions);
+        return q_instructions.load();
+    });
+}
+
+TEST_CASE("Day 9 BOOST", "[intcode][bench]") {
+    const char *filename = "inputs/day9.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("sensor boost mode", [&text] {
+        IntcodeComputer computer{0, text};
+        computer.push_input(2);
+        computer.run();
+        return computer.instructions_executed();
+    });
+}
+
+TEST_CASE("Day 11 painting robot", "[intcode][bench]") {
+    const char *filename = "inputs/day11.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("painting from a black panel", [&text] {
+        IntcodeComputer robot{0, text};
+        HullBrush brush;
+        paint_hull(robot, brush);
+        return robot.instructions_executed();
+    });
+}
+
+TEST_CASE("Day 13 arcade", "[intcode][bench]") {
+    const char *filename = "inputs/day13.txt";
+    if (!has_input(filename))
+        return;
+
+    Text text = read_text_program(filename);
+    // play for free
+    text[0] = 2;
+    measure("free play following the ball", [&text] {
+        Arkanoid arkanoid{text};
+        arkanoid.auto_play(false);
+        return arkanoid.instructions_executed();
+    });
+}
+
+TEST_CASE("Day 15 exploration", "[intcode][bench]") {
+    const char *filename = "inputs/day15.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("mapping the whole section", [&text] {
+        IntcodeComputer droid{0, text};
+        Section section;
+        return map_section(droid, Point{}, section);
+    });
+}
+
+TEST_CASE("Day 17 scaffold", "[intcode][bench]") {
+    const char *filename = "inputs/day17.txt";
+    if (!has_input(filename))
+        return;
+
+    const Text text = read_text_program(filename);
+    measure("camera view", [&text] {
+        IntcodeComputer camera{0, text};
+        camera.run(nullptr, 0, [](Value) {});
+        return camera.instructions_executed();
+    });
+}
+
+TEST_CASE("Day 19 beam", "[intcode][bench]") {
+    const char *filename = "inputs/day19.txt";
+    if (!has_input(filename))
+        return;
+
+    const auto drone = IntcodeComputer::partially_evaluated(0, read_text_program(filename));
+    measure("50x50 probes", [&drone] {
+        uint64_t q_instructions{};
+        for (Value x{}; x<50; ++x) {
+            for (Value y{}; y<50; ++y) {
+                auto probe = drone.fork();
+                probe.push_input(x);
+                probe.push_input(y);
+                probe.run();
+                q_instructions += probe.instructions_executed() - drone.instructions_executed();
+            }
+        }
+        return q_instructions;
+    });
+}
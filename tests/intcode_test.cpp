@@ -0,0 +1,679 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "catch.hpp"
+#include "intcode.hpp"
+#include "intcode_batch.hpp"
+#include "intcode_cache.hpp"
+#include "intcode_cfg.hpp"
+#include "intcode_compiled.hpp"
+#include "intcode_network.hpp"
+#include "intcode_symbolic.hpp"
+#include "phase_search.hpp"
+
+
+vector<Value> run_program(const Text &text, const vector<Value> &inputs) {
+    IntcodeComputer computer{0, text};
+    for (auto v: inputs)
+        computer.push_input(v);
+    computer.run();
+
+    vector<Value> outputs;
+    while (computer.output_size())
+        outputs.push_back(computer.pop_output());
+    return outputs;
+}
+
+// sums n, n - 1, ... 1 for the n it reads
+const Text sum_loop{3,100, 1101,0,0,101, 1,101,100,101, 1001,100,-1,100, 1005,100,6, 4,101, 99};
+
+
+TEST_CASE("Quine", "[intcode]") {
+    Text quine{109,1,204,-1,1001,100,1,100,1008,100,16,101,1006,101,0,99};
+    REQUIRE(run_program(quine, {}) == quine);
+}
+
+TEST_CASE("Large values", "[intcode]") {
+    REQUIRE(run_program({1102,34915192,34915192,7,4,7,99,0}, {}) == vector<Value>{1219070632396864});
+    REQUIRE(run_program({104,1125899906842624,99}, {}) == vector<Value>{1125899906842624});
+}
+
+TEST_CASE("Comparisons and jumps", "[intcode]") {
+    Text text{3,21,1008,21,8,20,1005,20,22,107,8,21,20,1006,20,31,1106,0,36,98,0,0,1002,21,125,20,4,20,1105,1,46,104,999,1105,1,46,1101,1000,1,20,4,20,1105,1,46,98,99};
+    REQUIRE(run_program(text, {7}) == vector<Value>{999});
+    REQUIRE(run_program(text, {8}) == vector<Value>{1000});
+    REQUIRE(run_program(text, {9}) == vector<Value>{1001});
+}
+
+TEST_CASE("Self-modifying code", "[intcode]") {
+    // outputs 7, overwrites its first instruction with a halt and jumps back to it
+    Text text{104,7,1101,0,99,0,1105,1,0};
+    IntcodeComputer computer{0, text};
+    computer.run();
+    REQUIRE(computer.has_terminated());
+    REQUIRE(computer.output_size() == 1);
+    REQUIRE(computer.pop_output() == 7);
+}
+
+TEST_CASE("Heap addresses", "[intcode]") {
+    // writes past the text, both into the page table and far beyond it, then reads back
+    const Value far{1000000000000};
+    Text text{1101,5,6,1000, 4,1000, 1101,7,8,far, 4,far, 4,70000, 99};
+    REQUIRE(run_program(text, {}) == vector<Value>{11, 15, 0});
+}
+
+TEST_CASE("Self-modifying parameters", "[intcode]") {
+    // outputs the immediate at address 1, increments it and loops until it reaches 9
+    Text text{104,7,1001,1,1,1,1007,1,9,15,1005,15,0,99,0,0};
+    REQUIRE(run_program(text, {}) == vector<Value>{7, 8});
+}
+
+TEST_CASE("Fused compare and jump", "[intcode]") {
+    // counts 0 to 4, the compare at 6 writes the flag the jump at 10 tests
+    Text loop{4,20,1001,20,1,20,1007,20,5,21,1005,21,0,99,0,0,0,0,0,0,0,0};
+    REQUIRE(run_program(loop, {}) == vector<Value>{0, 1, 2, 3, 4});
+
+    // output, add, compare and jump five times, then the halt
+    IntcodeComputer computer{0, loop};
+    computer.run();
+    REQUIRE(computer.instructions_executed() == 21);
+
+    // a relative write into the jump's condition parameter, turning it from 15 (zero) into 1 (five)
+    Text rewrite{109,5,21107,1,2,2,1005,15,12,104,0,99,104,1,99,0};
+    REQUIRE(run_program(rewrite, {}) == vector<Value>{1});
+}
+
+TEST_CASE("Forks don't see each other's writes", "[intcode]") {
+    // writes its input over the instruction at 6: 104 outputs 42 and loops, 99 halts
+    Text text{3,6,1105,1,6,0,0,42,1105,1,0};
+    IntcodeComputer parent{0, text};
+    parent.push_input(104);
+    parent.run();
+    REQUIRE(parent.pop_output() == 42);
+
+    auto child = parent.fork();
+    child.push_input(99);
+    child.run();
+    REQUIRE(child.has_terminated());
+    REQUIRE(child.output_size() == 0);
+
+    parent.push_input(104);
+    parent.run();
+    REQUIRE(!parent.has_terminated());
+    REQUIRE(parent.pop_output() == 42);
+}
+
+TEST_CASE("Span input and output sink", "[intcode]") {
+    // outputs its inputs doubled until it reads a 0
+    Text text{3,16,1006,16,14,102,2,16,16,4,16,1105,1,0,99,0,0};
+
+    IntcodeComputer computer{0, text};
+    vector<Value> outputs;
+    const OutputSink sink = [&](Value value) { outputs.push_back(value); };
+
+    // values pushed before go first
+    computer.push_input(1);
+    const Value inputs[]{2, 3};
+    REQUIRE(computer.run(inputs, 2, sink) == 2);
+    REQUIRE(outputs == vector<Value>{2, 4, 6});
+    REQUIRE(computer.output_size() == 0);
+    REQUIRE(!computer.has_terminated());
+
+    // stops taking from the span once it halts
+    const Value more[]{4, 0, 5};
+    REQUIRE(computer.run(more, 3, sink) == 2);
+    REQUIRE(outputs == vector<Value>{2, 4, 6, 8});
+    REQUIRE(computer.has_terminated());
+}
+
+TEST_CASE("ASCII lines and text", "[intcode]") {
+    // echoes characters up to a newline, then a value that isn't one
+    Text text{3,100, 4,100, 1008,100,10,101, 1006,101,0, 104,1000, 99};
+
+    IntcodeComputer computer{0, text};
+    computer.push_line("echo");
+    computer.run();
+    string echoed{"> "};
+    REQUIRE(computer.drain_text(echoed) == 5);
+    REQUIRE(echoed == "> echo\n");
+    REQUIRE(computer.drain_text(echoed) == 0);
+    REQUIRE(computer.output_size() == 1);
+    REQUIRE(computer.pop_output() == 1000);
+}
+
+TEST_CASE("Instruction budgets", "[intcode]") {
+    // counts 0 to 4 like the fused loop test, then asks for input
+    Text loop{4,20,1001,20,1,20,1007,20,5,21,1005,21,0,3,20,99,0,0,0,0,0,0};
+    IntcodeComputer computer{0, loop};
+
+    REQUIRE(computer.run(0) == RunStatus::budget_exhausted);
+    REQUIRE(computer.instructions_executed() == 0);
+
+    // the first output ends the slice early
+    REQUIRE(computer.run(100) == RunStatus::output_available);
+    REQUIRE(computer.instructions_executed() == 1);
+    REQUIRE(computer.pop_output() == 0);
+
+    // add, then the fused compare and jump going one over
+    REQUIRE(computer.run(2) == RunStatus::budget_exhausted);
+    REQUIRE(computer.instructions_executed() == 4);
+
+    RunStatus status;
+    while ((status = computer.run(100)) == RunStatus::output_available)
+        ;
+    REQUIRE(status == RunStatus::needs_input);
+    REQUIRE(computer.output_size() == 4);
+
+    computer.push_input(7);
+    REQUIRE(computer.run(100) == RunStatus::halted);
+    REQUIRE(computer.has_terminated());
+}
+
+TEST_CASE("Instructions executed before an exception", "[intcode]") {
+    // an add and an output, then an invalid opcode
+    Text text{1101,1,1,9, 104,7, 98, 0,0,0};
+    IntcodeComputer computer{0, text};
+    REQUIRE_THROWS_AS(computer.run(), runtime_error);
+    REQUIRE(computer.instructions_executed() == 3);
+
+    // the sum loop throwing on its only output
+    Text sum{sum_loop};
+    sum.resize(102);
+    IntcodeComputer summing{0, sum};
+    const Value inputs[]{1000};
+    const OutputSink sink = [](Value) { throw runtime_error("full"); };
+    REQUIRE_THROWS_AS(summing.run(inputs, 1, sink), runtime_error);
+    REQUIRE(summing.instructions_executed() == 3003);
+}
+
+TEST_CASE("Partially evaluated programs", "[intcode]") {
+    // outputs 5 before asking for anything, then echoes its input doubled
+    Text text{104,5,3,11,102,2,11,11,4,11,99,0};
+    const auto prefix = IntcodeComputer::partially_evaluated(0, text);
+    for (Value value: {1, 2}) {
+        auto computer = prefix.fork();
+        computer.push_input(value);
+        computer.run();
+        REQUIRE(computer.has_terminated());
+        REQUIRE(computer.pop_output() == 5);
+        REQUIRE(computer.pop_output() == 2 * value);
+    }
+}
+
+TEST_CASE("Run cache", "[intcode][cache]") {
+    // adds its two inputs
+    Text text{3,11,3,12,1,11,12,11,4,11,99,0,0};
+    IntcodeRunCache cache{2};
+    auto program = cache.add(text);
+
+    REQUIRE(cache.run(program, {1, 2}) == vector<Value>{3});
+    REQUIRE(cache.run(program, {3, 4}) == vector<Value>{7});
+    REQUIRE(cache.run(program, {1, 2}) == vector<Value>{3});
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 2);
+
+    // evicts {3, 4}, the least recently used
+    REQUIRE(cache.run(program, {5, 6}) == vector<Value>{11});
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.run(program, {1, 2}) == vector<Value>{3});
+    REQUIRE(cache.run(program, {3, 4}) == vector<Value>{7});
+    REQUIRE(cache.hits() == 2);
+    REQUIRE(cache.misses() == 4);
+
+    // a run still waiting for input isn't a complete result
+    REQUIRE_THROWS_AS(cache.run(program, {1}), runtime_error);
+    REQUIRE_THROWS_AS(cache.run(program + 1, {1, 2}), invalid_argument);
+
+    // the same program again has the same id, a different one its own
+    REQUIRE(cache.add(text) == program);
+    Text multiplying{text};
+    multiplying[4] = 2;
+    auto other = cache.add(multiplying);
+    REQUIRE(other != program);
+    REQUIRE(cache.run(other, {3, 4}) == vector<Value>{12});
+    REQUIRE(cache.run(program, {3, 4}) == vector<Value>{7});
+
+    // outputs outlive the entry they came from
+    IntcodeRunCache single{1};
+    program = single.add(text);
+    auto outputs = single.run(program, {1, 2});
+    single.run(program, {2, 3});
+    REQUIRE(outputs == vector<Value>{3});
+}
+
+TEST_CASE("Symbolic runs", "[intcode][symbolic]") {
+    // day 2 shaped: reads through the noun and verb first, then leaves 7 * noun + verb in cell 0
+    Text text{1,0,0,3, 1,1,2,3, 1,3,4,3, 2,1,22,23, 1,23,2,0, 99,0,7,0};
+    SymbolicRun run{text, {1, 2}};
+    REQUIRE(run.is_linear(0));
+    REQUIRE(run.evaluate(0, {12, 34}) == 118);
+    REQUIRE(run.solve(0, 118, {{0, 99}, {0, 99}}) == vector<Value>{3, 97});
+    REQUIRE(run.solve(0, 1000, {{0, 99}, {0, 99}}).empty());
+
+    // same answer as running it
+    IntcodeBatch batch{text, 1};
+    batch.set(0, 1, 3);
+    batch.set(0, 2, 97);
+    batch.run();
+    REQUIRE(batch.get(0, 0) == 118);
+
+    // a product of the unknowns is searched instead
+    SymbolicRun product{{2,9,10,0,99,0,0,0,0,0,0}, {9, 10}};
+    REQUIRE(!product.is_linear(0));
+    REQUIRE(product.solve(0, 12, {{0, 10}, {0, 10}}) == vector<Value>{2, 6});
+
+    // reading through an unknown address is only an error for the cells depending on it
+    SymbolicRun through{{1,0,0,0,99}, {1, 2}};
+    REQUIRE_THROWS_AS(through.evaluate(0, {0, 0}), runtime_error);
+    REQUIRE(through.evaluate(4, {0, 0}) == 99);
+
+    // control flow depending on an unknown
+    REQUIRE_THROWS_AS((SymbolicRun{{1005,5,4,99,99,0}, {5}}), runtime_error);
+}
+
+TEST_CASE("Phase permutation search", "[search]") {
+    // an ordering read as the digits of a number, phase 0 being digit 1
+    auto stage = [](Phase phase, int64_t signal) { return signal * 10 + phase + 1; };
+    auto evaluate = [&stage](vector<Phase> &ordering) {
+        int64_t signal{};
+        for (Phase phase: ordering)
+            signal = stage(phase, signal);
+        // not monotonic in the ordering, so every one has to be tried
+        return signal % 7919;
+    };
+
+    vector<Phase> phases{5, 2, 0, 4, 1, 3};
+    vector<Phase> ordering{phases};
+    sort(ordering.begin(), ordering.end());
+    int64_t best{};
+    do {
+        best = max(best, evaluate(ordering));
+    } while (next_permutation(ordering.begin(), ordering.end()));
+
+    for (size_t q_threads: {1, 3, 8}) {
+        REQUIRE(get_max_over_permutations(phases, evaluate, q_threads) == best);
+
+        // the first stage only runs once per phase
+        atomic<int> q_first_stages{}, q_stages{};
+        auto counted = [&](Phase phase, int64_t signal) {
+            ++q_stages;
+            if (!signal)
+                ++q_first_stages;
+            return stage(phase, signal);
+        };
+        REQUIRE(get_max_over_chains({0, 1, 2, 3, 4}, 0, counted, q_threads) == 54321);
+        REQUIRE(q_first_stages == 5);
+        REQUIRE(q_stages == 5 + 20 + 60 + 120 + 120);
+    }
+}
+
+TEST_CASE("Batch lanes match single computers", "[intcode][batch]") {
+    Text text{3,21,1008,21,8,20,1005,20,22,107,8,21,20,1006,20,31,1106,0,36,98,0,0,1002,21,125,20,4,20,1105,1,46,104,999,1105,1,46,1101,1000,1,20,4,20,1105,1,46,98,99};
+
+    IntcodeBatch batch{text, 16};
+    for (size_t lane{}; lane<batch.size(); ++lane)
+        batch.push_input(lane, lane);
+    batch.run();
+
+    for (size_t lane{}; lane<batch.size(); ++lane) {
+        REQUIRE(batch.has_terminated(lane));
+        REQUIRE(batch.output_size(lane) == 1);
+        REQUIRE(vector<Value>{batch.pop_output(lane)} == run_program(text, {static_cast<Value>(lane)}));
+    }
+}
+
+TEST_CASE("Batch lanes wait for input", "[intcode][batch]") {
+    // echoes inputs forever, using the relative base and the heap
+    Text text{109,500,203,0,204,0,1105,1,2};
+
+    IntcodeBatch batch{text, 3};
+    batch.push_input(1, 7);
+    batch.run();
+    REQUIRE(batch.output_size(0) == 0);
+    REQUIRE(batch.pop_output(1) == 7);
+    REQUIRE(!batch.has_terminated(1));
+
+    batch.push_input(0, 5);
+    batch.run();
+    REQUIRE(batch.pop_output(0) == 5);
+    REQUIRE(batch.get(0, 500) == 5);
+}
+
+TEST_CASE("Binary program files", "[intcode]") {
+    Text quine{109,1,204,-1,1001,100,1,100,1008,100,16,101,1006,101,0,99};
+    const char *filename = "intcode_test_quine.bin";
+
+    write_binary_program(quine, filename);
+    REQUIRE(is_binary_program(filename));
+    REQUIRE(read_binary_program(filename) == quine);
+
+    auto computer = IntcodeComputer::from_file(0, filename);
+    computer.run();
+    REQUIRE(computer.output_size() == quine.size());
+    remove(filename);
+}
+
+TEST_CASE("Snapshots", "[intcode]") {
+    // adds each input to a heap cell and a far one, outputting both running sums
+    const Value far{1000000000000};
+    Text text{3,100, 1,100,5000,5000, 1,100,far,far, 4,5000, 4,far, 1105,1,0};
+    const char *filename = "intcode_test_snapshot.bin";
+
+    IntcodeComputer computer{0, text};
+    computer.push_input(1);
+    computer.run();
+    // pending both ways
+    computer.push_input(2);
+    computer.save(filename);
+
+    auto restored = IntcodeComputer::restore(0, filename);
+    REQUIRE(restored.instructions_executed() == computer.instructions_executed());
+    for (auto *c: {&computer, &restored}) {
+        c->push_input(3);
+        c->run();
+    }
+    vector<Value> outputs, restored_outputs;
+    while (computer.output_size())
+        outputs.push_back(computer.pop_output());
+    while (restored.output_size())
+        restored_outputs.push_back(restored.pop_output());
+    REQUIRE(outputs == vector<Value>{1, 1, 3, 3, 6, 6});
+    REQUIRE(restored_outputs == outputs);
+    REQUIRE(!restored.has_terminated());
+
+    // again from pages the restored computer wrote to
+    restored.save(filename);
+    auto again = IntcodeComputer::restore(0, filename);
+    again.push_input(4);
+    again.run();
+    REQUIRE(again.pop_output() == 10);
+    remove(filename);
+}
+
+TEST_CASE("Control flow graph", "[intcode][cfg]") {
+    // the same program as the ahead of time test
+    Text text{
+        109,100, 3,50, 21101,11,0,0, 1105,1,30, 4,51, 1008,50,0,60, 1005,60,23, 1105,1,2,
+        1101,99,0,27, 104,7, 99, 1002,50,3,51, 2106,0,0
+    };
+    ControlFlowGraph graph{text};
+
+    REQUIRE(graph.get_instructions().size() == 13);
+    REQUIRE(graph.instruction_at(11) != nullptr);
+    REQUIRE(graph.instruction_at(12) == nullptr);
+    REQUIRE(graph.instruction_at(4)->instruction.modes[2] == 2);
+
+    const auto &blocks = graph.get_blocks();
+    REQUIRE(blocks.size() == 6);
+    REQUIRE(blocks.at(2).end == 11);
+    REQUIRE(blocks.at(2).successors == vector<Address>{30});
+    REQUIRE(blocks.at(11).successors == vector<Address>{23, 20});
+    REQUIRE(blocks.at(23).halts);
+    REQUIRE(blocks.at(30).computed_exit);
+
+    REQUIRE(graph.get_calls().size() == 1);
+    REQUIRE(graph.get_calls()[0].site == 8);
+    REQUIRE(graph.get_calls()[0].target == 30);
+    REQUIRE(graph.get_calls()[0].return_address == 11);
+    REQUIRE(graph.get_returns() == vector<Address>{34});
+
+    REQUIRE(graph.get_self_modifying_writes().size() == 1);
+    REQUIRE(graph.get_self_modifying_writes()[0].writer == 23);
+    REQUIRE(graph.get_self_modifying_writes()[0].instruction == 27);
+
+    ostringstream listing;
+    graph.write(listing);
+    REQUIRE(listing.str().find("jnz 1, 30") != string::npos);
+    REQUIRE(listing.str().find("; call 30, back at 11") != string::npos);
+}
+
+// tests/aot_test.txt, translated by intcode_aot when building the tests
+extern const CompiledProgram aot_test_program;
+
+TEST_CASE("Ahead of time compiled programs", "[intcode][aot]") {
+    // triples each input in a subroutine until a 0, then rewrites its last output into a halt
+    Text text{
+        109,100, 3,50, 21101,11,0,0, 1105,1,30, 4,51, 1008,50,0,60, 1005,60,23, 1105,1,2,
+        1101,99,0,27, 104,7, 99, 1002,50,3,51, 2106,0,0
+    };
+    REQUIRE(Text(aot_test_program.text, aot_test_program.text + aot_test_program.text_size) == text);
+
+    CompiledIntcodeComputer compiled{0, aot_test_program};
+    IntcodeComputer interpreted{0, text};
+    compiled.push_input(4);
+    REQUIRE(compiled.run() == 12);
+    REQUIRE(!compiled.has_terminated());
+
+    // the return is a computed jump and the halt only runs in the interpreter escape hatch
+    for (Value value: {5, 0})
+        compiled.push_input(value);
+    compiled.run();
+    REQUIRE(compiled.has_terminated());
+
+    for (Value value: {4, 5, 0})
+        interpreted.push_input(value);
+    interpreted.run();
+    vector<Value> outputs, interpreted_outputs;
+    while (compiled.output_size())
+        outputs.push_back(compiled.pop_output());
+    while (interpreted.output_size())
+        interpreted_outputs.push_back(interpreted.pop_output());
+    REQUIRE(outputs == vector<Value>{12, 15, 0});
+    REQUIRE(outputs == interpreted_outputs);
+}
+
+TEST_CASE("Network of computers passing a token", "[intcode][network]") {
+    // reads a value, outputs it plus one, forever
+    Text increment{3,100,1001,100,1,100,4,100,1105,1,0};
+    const size_t q_computers{1000};
+
+    IntcodeNetwork network;
+    for (size_t i{}; i<q_computers; ++i)
+        network.add(IntcodeComputer{static_cast<int>(i), increment});
+    for (size_t i{}; i+1<q_computers; ++i)
+        network.connect(i, i + 1);
+
+    network.send(0, 0);
+    network.run(4);
+    REQUIRE(network.outputs(q_computers - 1) == vector<Value>{q_computers});
+
+    // computers stay suspended on input and resume on the next run
+    network.send(0, 10);
+    network.run(2);
+    REQUIRE(network.last_output(q_computers - 1) == 10 + q_computers);
+}
+
+TEST_CASE("Network with a feedback loop", "[intcode][network]") {
+    Text amplifier{3,26,1001,26,-4,26,3,27,1002,27,2,27,1,27,26,27,4,27,1001,28,-1,28,1005,28,6,99,0,0,5};
+    vector<Value> phases{9,8,7,6,5};
+
+    IntcodeNetwork network;
+    for (size_t i{}; i<phases.size(); ++i) {
+        IntcodeComputer computer{static_cast<int>(i), amplifier};
+        computer.push_input(phases[i]);
+        network.add(computer);
+    }
+    for (size_t i{}; i<phases.size(); ++i)
+        network.connect(i, (i + 1) % phases.size());
+
+    network.send(0, 0);
+    network.run(3);
+    REQUIRE(network.computer(4).has_terminated());
+    REQUIRE(network.last_output(4) == 139629729);
+}
+
+// stores the squares of 0 to n - 1 from address 200 on through the relative base, then sums them
+// reading back the same way, the stores spilling into pages it has to allocate
+const Text squares_loop{3,100, 109,200, 2,101,101,102, 20101,0,102,0, 109,1, 1001,101,1,101, 8,101,100,103, 1006,103,4,
+                        109,-1, 201,0,104,104, 1001,101,-1,101, 1005,101,25, 4,104, 99};
+
+struct JitComparison {
+    vector<Value> outputs;
+    uint64_t q_executed;
+    bool terminated;
+};
+
+// runs the program in slices of the budget until it halts or needs more input than given
+JitComparison run_sliced(const Text &text, const vector<Value> &inputs, bool jit, uint64_t budget) {
+    IntcodeComputer computer{0, text};
+    if (jit)
+        computer.enable_jit();
+    for (auto v: inputs)
+        computer.push_input(v);
+
+    JitComparison result;
+    RunStatus status;
+    do {
+        status = computer.run(budget);
+        while (computer.output_size())
+            result.outputs.push_back(computer.pop_output());
+    } while (status == RunStatus::budget_exhausted || status == RunStatus::output_available);
+
+    result.q_executed = computer.instructions_executed();
+    result.terminated = computer.has_terminated();
+    return result;
+}
+
+TEST_CASE("JIT matches the interpreter", "[intcode][jit]") {
+    const Value far{1000000000000};
+    Text padded_squares{squares_loop};
+    padded_squares.resize(105);
+    Text padded_sum{sum_loop};
+    padded_sum.resize(102);
+
+    const vector<pair<Text, vector<Value>>> programs{
+        {{109,1,204,-1,1001,100,1,100,1008,100,16,101,1006,101,0,99}, {}},
+        {{1102,34915192,34915192,7,4,7,99,0}, {}},
+        {{3,21,1008,21,8,20,1005,20,22,107,8,21,20,1006,20,31,1106,0,36,98,0,0,1002,21,125,20,4,20,1105,1,46,104,999,1105,1,46,1101,1000,1,20,4,20,1105,1,46,98,99}, {9}},
+        {{104,7,1101,0,99,0,1105,1,0}, {}},
+        {{1101,5,6,1000, 4,1000, 1101,7,8,far, 4,far, 4,70000, 99}, {}},
+        {{104,7,1001,1,1,1,1007,1,9,15,1005,15,0,99,0,0}, {}},
+        {{109,5,21107,1,2,2,1005,15,12,104,0,99,104,1,99,0}, {}},
+        {{3,16,1006,16,14,102,2,16,16,4,16,1105,1,0,99,0,0}, {1, 2, 3}},
+        {padded_sum, {1000}},
+        // writes into its own code, so the equals at 14 is interpreted; decoding it once went on to
+        // decode the compares after it and the word at 26, which compiled code then overwrote
+        // behind the decode cache's back
+        {{2,34,32,27,3,39,1107,11,3,26,1107,11,10,17,8,35,12,14,1107,0,4,26,7,41,33,31,1107,0,4,16,99,1006,12,39,102,8,32,10,1,37,6,13,3,13,0,0,0,0}, {0, 1, 2}},
+        {padded_squares, {2000}},
+    };
+
+    for (const auto &[text, inputs]: programs) {
+        for (uint64_t budget: {uint64_t{1}, uint64_t{7}, uint64_t{40}, uint64_t{100000}}) {
+            auto interpreted = run_sliced(text, inputs, false, budget);
+            auto compiled = run_sliced(text, inputs, true, budget);
+            REQUIRE(compiled.outputs == interpreted.outputs);
+            REQUIRE(compiled.q_executed == interpreted.q_executed);
+            REQUIRE(compiled.terminated == interpreted.terminated);
+        }
+    }
+    REQUIRE(run_sliced(padded_squares, {2000}, true, 100000).outputs == vector<Value>{2664667000});
+}
+
+TEST_CASE("JIT suspends on input", "[intcode][jit]") {
+    Text text{sum_loop};
+    text.resize(102);
+    IntcodeComputer computer{0, text};
+    computer.enable_jit();
+
+    REQUIRE(computer.run(100000) == RunStatus::needs_input);
+    REQUIRE(computer.instructions_executed() == 0);
+    computer.push_input(1000);
+    REQUIRE(computer.run(100000) == RunStatus::output_available);
+    REQUIRE(computer.pop_output() == 500500);
+    REQUIRE(computer.run(100000) == RunStatus::halted);
+    REQUIRE(computer.instructions_executed() == 3004);
+#ifdef INTCODE_JIT
+    REQUIRE(computer.native_instructions_executed() > 2900);
+#endif
+}
+
+TEST_CASE("JIT falls back on code writing over itself", "[intcode][jit]") {
+    // adds the immediate at address 2 to a sum and increments it, until it reaches 50
+    Text text{1001,21,0,21, 1001,2,1,2, 1007,2,50,22, 1005,22,0, 4,21, 99, 0,0,0,0,0};
+    IntcodeComputer computer{0, text};
+    computer.enable_jit();
+    computer.run();
+    REQUIRE(computer.has_terminated());
+    REQUIRE(computer.pop_output() == 1225);
+    REQUIRE(computer.instructions_executed() == 202);
+#ifdef INTCODE_JIT
+    // the add reading the immediate is interpreted, the rest of the loop isn't
+    REQUIRE(computer.native_instructions_executed() > 100);
+    REQUIRE(computer.native_instructions_executed() < 202);
+#endif
+}
+
+TEST_CASE("JIT forks don't see each other's writes", "[intcode][jit]") {
+    // outputs its inputs doubled until it reads a 0
+    Text text{3,16,1006,16,14,102,2,16,16,4,16,1105,1,0,99,0,0};
+    IntcodeComputer parent{0, text};
+    parent.enable_jit();
+    parent.push_input(1);
+    parent.run();
+    REQUIRE(parent.pop_output() == 2);
+
+    auto child = parent.fork();
+    child.push_input(5);
+    child.push_input(0);
+    child.run();
+    REQUIRE(child.has_terminated());
+    REQUIRE(child.pop_output() == 10);
+
+    parent.push_input(3);
+    parent.run();
+    REQUIRE(!parent.has_terminated());
+    REQUIRE(parent.pop_output() == 6);
+
+    // writes its input over the instruction at 6, the same as the interpreted test
+    Text rewriting{3,6,1105,1,6,0,0,42,1105,1,0};
+    IntcodeComputer writer{0, rewriting};
+    writer.enable_jit();
+    writer.push_input(104);
+    writer.run();
+    REQUIRE(writer.pop_output() == 42);
+    auto halting = writer.fork();
+    halting.push_input(99);
+    halting.run();
+    REQUIRE(halting.has_terminated());
+    writer.push_input(104);
+    writer.run();
+    REQUIRE(!writer.has_terminated());
+    REQUIRE(writer.pop_output() == 42);
+}
+
+TEST_CASE("JIT passes on sink exceptions", "[intcode][jit]") {
+    Text text{sum_loop};
+    text.resize(102);
+    IntcodeComputer computer{0, text};
+    computer.enable_jit();
+    const Value inputs[]{1000};
+    const OutputSink sink = [](Value) { throw runtime_error("full"); };
+    REQUIRE_THROWS_AS(computer.run(inputs, 1, sink), runtime_error);
+    // the output throwing included, the same as the interpreter
+    REQUIRE(computer.instructions_executed() == 3003);
+}
+
+#ifdef INTCODE_PROFILE
+TEST_CASE("Profile counters", "[intcode][profile]") {
+    // the day 5 comparison program, taking the less than 8 branch
+    Text text{3,21,1008,21,8,20,1005,20,22,107,8,21,20,1006,20,31,1106,0,36,98,0,0,1002,21,125,20,4,20,1105,1,46,104,999,1105,1,46,1101,1000,1,20,4,20,1105,1,46,98,99};
+    IntcodeComputer computer{0, text};
+    computer.run();
+    computer.push_input(7);
+    computer.run();
+
+    const auto &profile = computer.get_profile();
+    REQUIRE(profile.q_input_stalls == 1);
+    REQUIRE(profile.q_by_handler[3] == 1);
+    REQUIRE(profile.q_by_handler[4] == 1);
+    REQUIRE(profile.q_by_handler[10] == 1);
+    REQUIRE(profile.q_by_word.at(1008) == 1);
+    REQUIRE(profile.q_by_address.at(0) == 1);
+    REQUIRE(profile.q_text_writes == 3);
+
+    ostringstream folded;
+    computer.write_profile_folded(folded, 16);
+    REQUIRE(folded.str().find("intcode_0;ip_0-15;ip_0 1\n") == 0);
+}
+#endif